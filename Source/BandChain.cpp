@@ -0,0 +1,43 @@
+#include "BandChain.h"
+
+void BandChainHandoff::publish(std::unique_ptr<BandChain> newChain)
+{
+    jassert(newChain != nullptr);
+    newChain->serial = nextSerial++;
+
+    if (owned != nullptr)
+        retired.push_back(std::move(owned));
+
+    owned = std::move(newChain);
+    latest.store(owned.get());
+
+    collectGarbage();
+}
+
+const BandChain* BandChainHandoff::acquire() noexcept
+{
+    auto* chain = latest.load();
+
+    // Pin the chain, then make sure it is still the published one. If the
+    // writer swapped in between it may already have checked the old pin, so
+    // retry with the newer chain instead of touching the old one.
+    for (;;)
+    {
+        pinned.store(chain);
+
+        auto* current = latest.load();
+        if (current == chain)
+            return chain;
+
+        chain = current;
+    }
+}
+
+void BandChainHandoff::collectGarbage()
+{
+    const auto* inUse = pinned.load();
+
+    retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                 [inUse](const auto& chain) { return chain.get() != inUse; }),
+                  retired.end());
+}
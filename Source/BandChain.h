@@ -0,0 +1,89 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "EQBand.h"
+
+/** An immutable copy of the band list as seen by the audio thread.
+    The message thread builds a new chain for every edit and hands it over
+    through a BandChainHandoff; a published chain is never modified again.
+    Only parameters are carried: the audio thread designs coefficients for
+    whatever rate it runs the bands at.
+*/
+struct BandChain
+{
+    static constexpr int maxBands = 64;
+
+    struct Band
+    {
+        juce::uint32 id;
+        BiquadDesign::Parameters parameters;
+        ChannelTarget target = ChannelTarget::Stereo;
+        BandDynamics dynamics {};
+        BandTracking tracking {};
+
+        // While morphing between snapshots, the settings at the far end: the
+        // band runs from parameters to morphTarget as the morph position
+        // goes from 0 to 1
+        bool morphs = false;
+        BiquadDesign::Parameters morphTarget {};
+
+        // The host parameter slot the band is mirrored in, -1 for none
+        int slot = -1;
+
+        /** The band's settings at a morph position; its own if it doesn't morph. */
+        BiquadDesign::Parameters getParametersAt(float morphPosition) const noexcept
+        {
+            return morphs ? BiquadDesign::interpolate(parameters, morphTarget, morphPosition) : parameters;
+        }
+
+        /** True if the band's gain follows its key signal. */
+        bool isDynamic() const noexcept
+        {
+            return dynamics.enabled && (parameters.type == FilterType::Peak
+                                        || parameters.type == FilterType::LowShelf
+                                        || parameters.type == FilterType::HighShelf);
+        }
+    };
+
+    std::vector<Band> bands;
+    juce::uint64 serial = 0;
+};
+
+/** RCU-style single-writer handoff of BandChain snapshots.
+
+    The writer (message thread) publishes a new chain with one atomic pointer
+    swap. The reader (audio thread) pins whatever it acquired, hazard-pointer
+    style, so the writer only frees retired chains the reader can no longer
+    reach. The reader never locks, allocates or frees.
+*/
+class BandChainHandoff
+{
+public:
+    BandChainHandoff() = default;
+    ~BandChainHandoff() = default;
+
+    /** Message thread: makes newChain the current chain and reclaims old ones. */
+    void publish(std::unique_ptr<BandChain> newChain);
+
+    /** Audio thread: returns the current chain, which stays valid until the next call. */
+    const BandChain* acquire() noexcept;
+
+    /** Message thread: frees every retired chain that is not pinned by the reader. */
+    void collectGarbage();
+
+    /** Message thread: the most recently published chain. */
+    const BandChain* getLatest() const noexcept { return owned.get(); }
+
+private:
+    std::atomic<BandChain*> latest { nullptr };
+    std::atomic<const BandChain*> pinned { nullptr };
+
+    std::unique_ptr<BandChain> owned;
+    std::vector<std::unique_ptr<BandChain>> retired;
+    juce::uint64 nextSerial = 1;
+
+    JUCE_DECLARE_NON_COPYABLE(BandChainHandoff)
+};
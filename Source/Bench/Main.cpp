@@ -0,0 +1,556 @@
+/*
+    sondyeq-bench: microbenchmarks for the processing chain.
+
+    Usage:
+        sondyeq-bench [--output <file.json>] [--quick]
+
+    Measures SondyEQAudioProcessor::processBlock while sweeping one dimension
+    at a time around a default configuration (8 Peak bands, 512-sample
+    blocks, stereo, 48 kHz): band count, filter type, block size, channel
+    count, sample rate, processing mode, how many bands are dynamic and
+    sample precision (float or double buffers). Coefficient recompute cost and
+    analyzer cost are measured separately, outside processBlock.
+
+    Every result reports ns/sample and, on x86, cycles/sample read from the
+    timestamp counter (which ticks at the nominal clock, not the boosted one).
+    "Sample" means one sample frame, across all channels; the channel count
+    is part of each record. The JSON goes to stdout, or to --output, so runs
+    can be diffed against a stored baseline.
+*/
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_events/juce_events.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include "PluginProcessor.h"
+#include "BiquadCascade.h"
+#include "FFT.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace
+{
+    constexpr int defaultNumBands = 8;
+    constexpr FilterType defaultType = FilterType::Peak;
+    constexpr int defaultBlockSize = 512;
+    constexpr int defaultNumChannels = 2;
+    constexpr double defaultSampleRate = 48000.0;
+
+    const std::pair<const char*, FilterType> filterTypes[] =
+    {
+        { "LowShelf",  FilterType::LowShelf },
+        { "HighShelf", FilterType::HighShelf },
+        { "Peak",      FilterType::Peak },
+        { "Notch",     FilterType::Notch },
+        { "LowPass",   FilterType::LowPass },
+        { "HighPass",  FilterType::HighPass }
+    };
+
+    const char* getTypeName(FilterType type)
+    {
+        for (const auto& entry : filterTypes)
+            if (entry.second == type)
+                return entry.first;
+
+        return "Unknown";
+    }
+
+    bool hasCycleCounter()
+    {
+       #if JUCE_INTEL
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+    juce::uint64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return static_cast<juce::uint64>(__rdtsc());
+       #else
+        return 0;
+       #endif
+    }
+
+    /** Cost of one call, averaged over a timed run. */
+    struct Timing
+    {
+        double nanoseconds = 0.0;
+        double cycles = 0.0;
+    };
+
+    /** Calls fn a few times to warm caches and branch predictors, then keeps
+        calling it until both minCalls and minSeconds have been reached.
+    */
+    template <typename Function>
+    Timing measure(Function&& fn, int minCalls, double minSeconds)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        for (int i = 0; i < juce::jmax(1, minCalls / 10); ++i)
+            fn();
+
+        juce::int64 calls = 0;
+        const auto startTime = Clock::now();
+        const auto startCycles = readCycleCounter();
+        double elapsedSeconds = 0.0;
+
+        // Check the clock every few calls so reading it doesn't show up in short runs
+        while (calls < minCalls || elapsedSeconds < minSeconds)
+        {
+            for (int i = 0; i < 16; ++i)
+                fn();
+
+            calls += 16;
+            elapsedSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+        }
+
+        const auto elapsedCycles = readCycleCounter() - startCycles;
+
+        Timing timing;
+        timing.nanoseconds = elapsedSeconds * 1.0e9 / static_cast<double>(calls);
+        timing.cycles = static_cast<double>(elapsedCycles) / static_cast<double>(calls);
+        return timing;
+    }
+
+    /** Bands spread log-evenly over 40 Hz - 16 kHz with alternating gains, so
+        none of them is skipped as unity.
+    */
+    std::vector<BiquadDesign::Parameters> makeBands(int numBands, FilterType type)
+    {
+        std::vector<BiquadDesign::Parameters> bands;
+
+        for (int i = 0; i < numBands; ++i)
+        {
+            const auto position = numBands > 1 ? static_cast<float>(i) / static_cast<float>(numBands - 1) : 0.5f;
+
+            BiquadDesign::Parameters band;
+            band.type = type;
+            band.frequency = 40.0f * std::pow(400.0f, position);
+            band.gain = (i % 2 == 0) ? 6.0f : -4.0f;
+            band.q = 0.7f + 0.1f * static_cast<float>(i % 5);
+            bands.push_back(band);
+        }
+
+        return bands;
+    }
+
+    template <typename SampleType>
+    void fillWithNoise(juce::AudioBuffer<SampleType>& buffer)
+    {
+        juce::Random random(0x5eed);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(ch, i, static_cast<SampleType>(random.nextFloat() * 0.5f - 0.25f));
+    }
+
+    enum class Mode
+    {
+        minimumPhase,
+        oversampling2x,
+        oversampling4x,
+        oversampling8x,
+        linearPhase,
+        stateVariable
+    };
+
+    const std::pair<const char*, Mode> modes[] =
+    {
+        { "MinimumPhase",   Mode::minimumPhase },
+        { "Oversampling2x", Mode::oversampling2x },
+        { "Oversampling4x", Mode::oversampling4x },
+        { "Oversampling8x", Mode::oversampling8x },
+        { "LinearPhase",    Mode::linearPhase },
+        { "StateVariable",  Mode::stateVariable }
+    };
+
+    struct Config
+    {
+        juce::String sweep;
+        int numBands = defaultNumBands;
+        FilterType type = defaultType;
+        int blockSize = defaultBlockSize;
+        int numChannels = defaultNumChannels;
+        double sampleRate = defaultSampleRate;
+        Mode mode = Mode::minimumPhase;
+        int numDynamicBands = 0;
+        bool doublePrecision = false;
+    };
+
+    class Bench
+    {
+    public:
+        explicit Bench(bool quickRun)
+            : minSeconds(quickRun ? 0.05 : 0.4)
+        {
+        }
+
+        juce::Array<juce::var> results;
+
+        void run()
+        {
+            runProcessBlockSweeps();
+            runCoefficientBenchmarks();
+            runAnalyzerBenchmarks();
+        }
+
+    private:
+        const double minSeconds;
+
+        void addResult(juce::DynamicObject* record, const Timing& timing, double samplesPerCall)
+        {
+            record->setProperty("nsPerSample", timing.nanoseconds / samplesPerCall);
+
+            if (hasCycleCounter())
+                record->setProperty("cyclesPerSample", timing.cycles / samplesPerCall);
+            else
+                record->setProperty("cyclesPerSample", juce::var());
+
+            results.add(juce::var(record));
+        }
+
+        //==============================================================================
+        void runProcessBlockSweeps()
+        {
+            for (const int numBands : { 1, 2, 4, 8, 16, 32, 64 })
+            {
+                Config config;
+                config.sweep = "bands";
+                config.numBands = numBands;
+                runProcessBlock(config);
+            }
+
+            for (const auto& entry : filterTypes)
+            {
+                Config config;
+                config.sweep = "type";
+                config.type = entry.second;
+                runProcessBlock(config);
+            }
+
+            for (const int blockSize : { 1, 4, 16, 64, 256, 1024, 4096 })
+            {
+                Config config;
+                config.sweep = "blockSize";
+                config.blockSize = blockSize;
+                runProcessBlock(config);
+            }
+
+            for (const int numChannels : { 1, 2, 6, 8, 16 })
+            {
+                Config config;
+                config.sweep = "channels";
+                config.numChannels = numChannels;
+                runProcessBlock(config);
+            }
+
+            for (const double sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+            {
+                Config config;
+                config.sweep = "sampleRate";
+                config.sampleRate = sampleRate;
+                runProcessBlock(config);
+            }
+
+            for (const auto& entry : modes)
+            {
+                Config config;
+                config.sweep = "mode";
+                config.mode = entry.second;
+                runProcessBlock(config);
+            }
+
+            for (const int numDynamicBands : { 0, 1, 2, 4, 8 })
+            {
+                Config config;
+                config.sweep = "dynamicBands";
+                config.numDynamicBands = numDynamicBands;
+                runProcessBlock(config);
+            }
+
+            for (const bool doublePrecision : { false, true })
+            {
+                Config config;
+                config.sweep = "precision";
+                config.doublePrecision = doublePrecision;
+                runProcessBlock(config);
+            }
+        }
+
+        void runProcessBlock(const Config& config)
+        {
+            SondyEQAudioProcessor processor;
+            // Only the main buses change; the sidechain stays disabled
+            const auto layout = juce::AudioChannelSet::canonicalChannelSet(config.numChannels);
+            auto buses = processor.getBusesLayout();
+            buses.inputBuses.getReference(0) = layout;
+            buses.outputBuses.getReference(0) = layout;
+
+            if (!processor.setBusesLayout(buses))
+            {
+                std::cerr << "skipping " << config.numChannels << " channels: layout not supported" << std::endl;
+                return;
+            }
+
+            processor.setProcessingPrecision(config.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                    : juce::AudioProcessor::singlePrecision);
+
+            auto& existing = processor.getBands();
+
+            while (!existing.empty())
+                processor.removeBand(existing.back().get());
+
+            for (const auto& parameters : makeBands(config.numBands, config.type))
+            {
+                auto band = std::make_unique<EQBand>();
+                band->setType(parameters.type);
+                band->setFrequency(parameters.frequency);
+                band->setGain(parameters.gain);
+                band->setQ(parameters.q);
+
+                // A low threshold keeps every dynamic band moving
+                if (static_cast<int>(existing.size()) < config.numDynamicBands)
+                {
+                    BandDynamics dynamics;
+                    dynamics.enabled = true;
+                    dynamics.threshold = -60.0f;
+                    band->setDynamics(dynamics);
+                }
+
+                processor.addBand(std::move(band));
+            }
+
+            switch (config.mode)
+            {
+                case Mode::oversampling2x: processor.setOversamplingOrder(1); break;
+                case Mode::oversampling4x: processor.setOversamplingOrder(2); break;
+                case Mode::oversampling8x: processor.setOversamplingOrder(3); break;
+                case Mode::linearPhase:    processor.setLinearPhaseEnabled(true); break;
+                case Mode::stateVariable:  processor.setFilterTopology(FilterTopology::StateVariable); break;
+                case Mode::minimumPhase:   break;
+            }
+
+            // Prepared last, with the bands and mode in place, so that the
+            // linear-phase kernel is designed here rather than on the design
+            // thread while the timing runs
+            processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+            const auto timing = config.doublePrecision ? measureProcessBlock<double>(processor, config)
+                                                       : measureProcessBlock<float>(processor, config);
+            processor.releaseResources();
+
+            auto* record = new juce::DynamicObject();
+            record->setProperty("benchmark", "processBlock");
+            record->setProperty("sweep", config.sweep);
+            record->setProperty("bands", config.numBands);
+            record->setProperty("type", getTypeName(config.type));
+            record->setProperty("blockSize", config.blockSize);
+            record->setProperty("channels", config.numChannels);
+            record->setProperty("sampleRate", config.sampleRate);
+            record->setProperty("dynamicBands", config.numDynamicBands);
+            record->setProperty("precision", config.doublePrecision ? "double" : "float");
+
+            for (const auto& entry : modes)
+                if (entry.second == config.mode)
+                    record->setProperty("mode", entry.first);
+
+            addResult(record, timing, static_cast<double>(config.blockSize));
+        }
+
+        template <typename SampleType>
+        Timing measureProcessBlock(SondyEQAudioProcessor& processor, const Config& config)
+        {
+            // Each call gets fresh noise from a source block, so the gain of the
+            // chain can't compound; the copy is included in the timing
+            juce::AudioBuffer<SampleType> source(config.numChannels, config.blockSize);
+            juce::AudioBuffer<SampleType> buffer(config.numChannels, config.blockSize);
+            juce::MidiBuffer midi;
+            fillWithNoise(source);
+
+            return measure([&]
+            {
+                for (int ch = 0; ch < config.numChannels; ++ch)
+                    buffer.copyFrom(ch, 0, source, ch, 0, config.blockSize);
+
+                processor.processBlock(buffer, midi);
+            }, juce::jmax(64, 65536 / config.blockSize), minSeconds);
+        }
+
+        //==============================================================================
+        // Recompute costs are reported per band, so "sample" is one band here
+        void runCoefficientBenchmarks()
+        {
+            for (const auto& entry : filterTypes)
+            {
+                const auto bands = makeBands(BandChain::maxBands, entry.second);
+                std::vector<BiquadDesign::Coefficients> coefficients(bands.size());
+
+                addCoefficientResult("BiquadDesign::design", entry.first, measure([&]
+                {
+                    for (size_t i = 0; i < bands.size(); ++i)
+                        BiquadDesign::design(bands[i], defaultSampleRate, coefficients[i]);
+                }, 1000, minSeconds), BandChain::maxBands);
+
+                addCoefficientResult("BiquadDesign::designBatch", entry.first, measure([&]
+                {
+                    BiquadDesign::designBatch(bands.data(), coefficients.data(),
+                                              static_cast<int>(bands.size()), defaultSampleRate);
+                }, 1000, minSeconds), BandChain::maxBands);
+
+                // What the message thread pays for an edit: the band's own
+                // redesign plus invalidating its response curve
+                EQBand band;
+                band.setSampleRate(defaultSampleRate);
+                band.setType(entry.second);
+                float gain = 1.0f;
+
+                addCoefficientResult("EQBand::updateFilter", entry.first, measure([&]
+                {
+                    band.setGain(gain);
+                    gain = -gain;
+                }, 1000, minSeconds), 1);
+
+                // What the audio thread pays when a new chain arrives
+                BandChain chainA, chainB;
+
+                for (size_t i = 0; i < bands.size(); ++i)
+                {
+                    chainA.bands.push_back({ static_cast<juce::uint32>(i + 1), bands[i] });
+                    auto altered = bands[i];
+                    altered.gain += 1.0f;
+                    chainB.bands.push_back({ static_cast<juce::uint32>(i + 1), altered });
+                }
+
+                BiquadCascade<float> cascade;
+                cascade.prepare(defaultSampleRate, defaultNumChannels, defaultBlockSize);
+                bool useA = true;
+
+                addCoefficientResult("BiquadCascade::setChain", entry.first, measure([&]
+                {
+                    cascade.setChain(useA ? chainA : chainB);
+                    useA = !useA;
+                }, 1000, minSeconds), BandChain::maxBands);
+            }
+        }
+
+        void addCoefficientResult(const char* name, const char* typeName, const Timing& timing, int bandsPerCall)
+        {
+            auto* record = new juce::DynamicObject();
+            record->setProperty("benchmark", name);
+            record->setProperty("type", typeName);
+            record->setProperty("sampleRate", defaultSampleRate);
+            record->setProperty("unit", "band");
+
+            addResult(record, timing, static_cast<double>(bandsPerCall));
+        }
+
+        //==============================================================================
+        void runAnalyzerBenchmarks()
+        {
+            constexpr int fftOrder = 11;  // the size the editor's analyzer uses
+            constexpr int chunkSize = 512;
+
+            juce::AudioBuffer<float> noise(1, chunkSize);
+            fillWithNoise(noise);
+            const auto* samples = noise.getReadPointer(0);
+
+            for (const int overlap : { 2, 4, 8 })
+            {
+                SondyFFT::FFTSpectrumAnalyzer analyzer(fftOrder);
+                analyzer.setHopSize((1 << fftOrder) / overlap);
+
+                addAnalyzerResult("FFTSpectrumAnalyzer::pushNextSample", fftOrder, overlap, measure([&]
+                {
+                    for (int i = 0; i < chunkSize; ++i)
+                        analyzer.pushNextSample(samples[i]);
+                }, 256, minSeconds), chunkSize);
+
+                addAnalyzerResult("FFTSpectrumAnalyzer::pushSamples", fftOrder, overlap, measure([&]
+                {
+                    analyzer.pushSamples(samples, chunkSize);
+                }, 256, minSeconds), chunkSize);
+            }
+        }
+
+        void addAnalyzerResult(const char* name, int fftOrder, int overlap, const Timing& timing, int samplesPerCall)
+        {
+            auto* record = new juce::DynamicObject();
+            record->setProperty("benchmark", name);
+            record->setProperty("fftSize", 1 << fftOrder);
+            record->setProperty("hopSize", (1 << fftOrder) / overlap);
+            record->setProperty("channels", 1);
+            addResult(record, timing, static_cast<double>(samplesPerCall));
+        }
+    };
+
+    juce::var describeSystem()
+    {
+        auto* system = new juce::DynamicObject();
+        system->setProperty("cpu", juce::SystemStats::getCpuModel());
+        system->setProperty("cpuMHz", juce::SystemStats::getCpuSpeedInMegahertz());
+        system->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        system->setProperty("juce", juce::SystemStats::getJUCEVersion());
+        system->setProperty("cycleCounter", hasCycleCounter() ? "rdtsc" : "none");
+        system->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+        return juce::var(system);
+    }
+
+    int printUsage()
+    {
+        std::cerr << "usage: sondyeq-bench [--output <file.json>] [--quick]" << std::endl;
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::File outputFile;
+    bool quickRun = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String argument(argv[i]);
+
+        if (argument == "--output" && i + 1 < argc)
+            outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (argument == "--quick")
+            quickRun = true;
+        else
+            return printUsage();
+    }
+
+    Bench bench(quickRun);
+    bench.run();
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("system", describeSystem());
+    report->setProperty("results", bench.results);
+
+    const auto json = juce::JSON::toString(juce::var(report));
+
+    if (outputFile == juce::File())
+    {
+        std::cout << json << std::endl;
+        return 0;
+    }
+
+    if (!outputFile.replaceWithText(json))
+    {
+        std::cerr << "can't write " << outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
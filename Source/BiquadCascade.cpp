@@ -0,0 +1,718 @@
+#include "BiquadCascade.h"
+
+namespace
+{
+    /** One section over a tile, with its coefficients and state held in registers. */
+    template <typename SampleType>
+    inline void runSection(SampleType* tile, int tileLength,
+                           LaneVector<SampleType> c0, LaneVector<SampleType> c1, LaneVector<SampleType> c2,
+                           LaneVector<SampleType> d1, LaneVector<SampleType> d2,
+                           LaneVector<SampleType>& state1, LaneVector<SampleType>& state2) noexcept
+    {
+        constexpr auto numLanes = BiquadCascade<SampleType>::numLanes;
+        auto z1 = state1;
+        auto z2 = state2;
+
+        for (int i = 0; i < tileLength; ++i)
+        {
+            auto* frame = tile + i * numLanes;
+            const auto in = LaneVector<SampleType>::fromRawArray(frame);
+            const auto out = c0 * in + z1;
+            z1 = c1 * in - d1 * out + z2;
+            z2 = c2 * in - d2 * out;
+            out.copyToRawArray(frame);
+        }
+
+        state1 = z1;
+        state2 = z2;
+    }
+
+    /** A ramped section: the coefficients step linearly from one design to the
+        next across the tile, arriving at the second on its last sample.
+    */
+    template <typename SampleType>
+    inline void runRampedSection(SampleType* tile, int tileLength,
+                                 const LaneVector<SampleType> (&from)[5], const LaneVector<SampleType> (&to)[5],
+                                 LaneVector<SampleType>& state1, LaneVector<SampleType>& state2) noexcept
+    {
+        constexpr auto numLanes = BiquadCascade<SampleType>::numLanes;
+        const auto scale = LaneVector<SampleType>::expand(SampleType(1) / static_cast<SampleType>(tileLength));
+        auto c0 = from[0], c1 = from[1], c2 = from[2], d1 = from[3], d2 = from[4];
+        const auto step0 = (to[0] - c0) * scale, step1 = (to[1] - c1) * scale, step2 = (to[2] - c2) * scale;
+        const auto step3 = (to[3] - d1) * scale, step4 = (to[4] - d2) * scale;
+        auto z1 = state1;
+        auto z2 = state2;
+
+        for (int i = 0; i < tileLength; ++i)
+        {
+            c0 = c0 + step0;
+            c1 = c1 + step1;
+            c2 = c2 + step2;
+            d1 = d1 + step3;
+            d2 = d2 + step4;
+
+            auto* frame = tile + i * numLanes;
+            const auto in = LaneVector<SampleType>::fromRawArray(frame);
+            const auto out = c0 * in + z1;
+            z1 = c1 * in - d1 * out + z2;
+            z2 = c2 * in - d2 * out;
+            out.copyToRawArray(frame);
+        }
+
+        state1 = z1;
+        state2 = z2;
+    }
+
+    /** One sample of a state-variable filter, given a1 = 1 / (1 + g (g + k)),
+        a2 = g a1, a3 = g a2 and the output mix; ic1 and ic2 are its integrators.
+    */
+    template <typename SampleType>
+    inline LaneVector<SampleType> tickStateVariable(LaneVector<SampleType> in,
+                                                    LaneVector<SampleType> a1, LaneVector<SampleType> a2, LaneVector<SampleType> a3,
+                                                    LaneVector<SampleType> m0, LaneVector<SampleType> m1, LaneVector<SampleType> m2,
+                                                    LaneVector<SampleType>& ic1, LaneVector<SampleType>& ic2) noexcept
+    {
+        const auto v3 = in - ic2;
+        const auto v1 = a1 * ic1 + a2 * v3;
+        const auto v2 = ic2 + a2 * ic1 + a3 * v3;
+        ic1 = v1 + v1 - ic1;
+        ic2 = v2 + v2 - ic2;
+        return m0 * in + m1 * v1 + m2 * v2;
+    }
+
+    /** A state-variable section over a tile, from g, 1 / (1 + g (g + k)) and the output mix. */
+    template <typename SampleType>
+    inline void runStateVariableSection(SampleType* tile, int tileLength,
+                                        LaneVector<SampleType> g, LaneVector<SampleType> a1,
+                                        LaneVector<SampleType> m0, LaneVector<SampleType> m1, LaneVector<SampleType> m2,
+                                        LaneVector<SampleType>& state1, LaneVector<SampleType>& state2) noexcept
+    {
+        constexpr auto numLanes = BiquadCascade<SampleType>::numLanes;
+        const auto a2 = g * a1;
+        const auto a3 = g * a2;
+        auto ic1 = state1;
+        auto ic2 = state2;
+
+        for (int i = 0; i < tileLength; ++i)
+        {
+            auto* frame = tile + i * numLanes;
+            const auto in = LaneVector<SampleType>::fromRawArray(frame);
+            tickStateVariable(in, a1, a2, a3, m0, m1, m2, ic1, ic2).copyToRawArray(frame);
+        }
+
+        state1 = ic1;
+        state2 = ic2;
+    }
+
+    template <typename SampleType>
+    inline LaneVector<SampleType> reciprocal(LaneVector<SampleType> x) noexcept
+    {
+        constexpr auto numLanes = BiquadCascade<SampleType>::numLanes;
+        alignas(64) SampleType values[numLanes];
+        x.copyToRawArray(values);
+
+        for (auto& value : values)
+            value = SampleType(1) / value;
+
+        return LaneVector<SampleType>::fromRawArray(values);
+    }
+
+    /** A ramped state-variable section: g, k and the mix step linearly from
+        one design to the next, and the filter is re-solved every sample.
+        Every point on the way has g > 0 and k > 0, so it stays stable
+        however far apart the designs are.
+    */
+    template <typename SampleType>
+    inline void runRampedStateVariableSection(SampleType* tile, int tileLength,
+                                              const LaneVector<SampleType> (&from)[5], const LaneVector<SampleType> (&to)[5],
+                                              LaneVector<SampleType>& state1, LaneVector<SampleType>& state2) noexcept
+    {
+        constexpr auto numLanes = BiquadCascade<SampleType>::numLanes;
+        const auto scale = LaneVector<SampleType>::expand(SampleType(1) / static_cast<SampleType>(tileLength));
+        const auto one = LaneVector<SampleType>::expand(SampleType(1));
+        auto g = from[0], k = from[1], m0 = from[2], m1 = from[3], m2 = from[4];
+        const auto step0 = (to[0] - g) * scale, step1 = (to[1] - k) * scale, step2 = (to[2] - m0) * scale;
+        const auto step3 = (to[3] - m1) * scale, step4 = (to[4] - m2) * scale;
+        auto ic1 = state1;
+        auto ic2 = state2;
+
+        for (int i = 0; i < tileLength; ++i)
+        {
+            g = g + step0;
+            k = k + step1;
+            m0 = m0 + step2;
+            m1 = m1 + step3;
+            m2 = m2 + step4;
+
+            const auto a1 = reciprocal(one + g * (g + k));
+            const auto a2 = g * a1;
+            const auto a3 = g * a2;
+
+            auto* frame = tile + i * numLanes;
+            const auto in = LaneVector<SampleType>::fromRawArray(frame);
+            tickStateVariable(in, a1, a2, a3, m0, m1, m2, ic1, ic2).copyToRawArray(frame);
+        }
+
+        state1 = ic1;
+        state2 = ic2;
+    }
+
+    // What lanes a targeted section leaves alone hold, so they pass the
+    // input unchanged: b0 = 1 for biquads, m0 = 1 and g = 0 for
+    // state-variable designs, and the same with 1 / (1 + g (g + k)) = 1
+    // once in the form static state-variable sections run on
+    template <typename SampleType>
+    constexpr BiquadDesign::CoefficientsOf<SampleType> biquadIdentity { 1, 0, 0, 0, 0 };
+
+    template <typename SampleType>
+    constexpr BiquadDesign::CoefficientsOf<SampleType> stateVariableIdentity { 0, 0, 1, 0, 0 };
+
+    template <typename SampleType>
+    constexpr BiquadDesign::CoefficientsOf<SampleType> stateVariableRunIdentity { 0, 1, 1, 0, 0 };
+
+    /** g, k, m0, m1, m2 as a static section runs them: k becomes 1 / (1 + g (g + k)). */
+    template <typename SampleType>
+    inline BiquadDesign::CoefficientsOf<SampleType> getRunForm(const BiquadDesign::CoefficientsOf<SampleType>& c) noexcept
+    {
+        auto result = c;
+        result[1] = SampleType(1) / (SampleType(1) + c[0] * (c[0] + c[1]));
+        return result;
+    }
+
+    /** Coefficients in every lane, or in one lane with the identity in the others. */
+    template <typename SampleType>
+    inline void loadLanes(const BiquadDesign::CoefficientsOf<SampleType>& c,
+                          const BiquadDesign::CoefficientsOf<SampleType>& identity, int lane,
+                          LaneVector<SampleType> (&result)[5]) noexcept
+    {
+        constexpr auto numLanes = BiquadCascade<SampleType>::numLanes;
+
+        if (lane < 0)
+        {
+            for (int k = 0; k < 5; ++k)
+                result[k] = LaneVector<SampleType>::expand(c[static_cast<size_t>(k)]);
+            return;
+        }
+
+        alignas(64) SampleType lanes[5][numLanes];
+
+        for (int k = 0; k < 5; ++k)
+        {
+            for (auto& value : lanes[k])
+                value = identity[static_cast<size_t>(k)];
+
+            lanes[k][lane] = c[static_cast<size_t>(k)];
+            result[k] = LaneVector<SampleType>::fromRawArray(lanes[k]);
+        }
+    }
+
+    /** Converts lanes 0 and 1 of a tile between left/right and mid/side. */
+    template <typename SampleType>
+    inline void convertPair(SampleType* tile, int tileLength, bool toMidSide) noexcept
+    {
+        constexpr auto numLanes = BiquadCascade<SampleType>::numLanes;
+        const auto scale = toMidSide ? SampleType(0.5) : SampleType(1);
+
+        for (int i = 0; i < tileLength; ++i)
+        {
+            auto* frame = tile + i * numLanes;
+            const auto a = frame[0];
+            const auto b = frame[1];
+            frame[0] = (a + b) * scale;
+            frame[1] = (a - b) * scale;
+        }
+    }
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::prepare(double newSampleRate, int newNumChannels, int maxBlockSize)
+{
+    sampleRate = newSampleRate;
+    numChannels = newNumChannels;
+    numGroups = (numChannels + numLanes - 1) / numLanes;
+
+    const auto stateSize = static_cast<size_t>(numGroups * maxSections);
+    const auto zero = Lanes::expand(0);
+    s1.assign(stateSize, zero);
+    s2.assign(stateSize, zero);
+    scratchS1.assign(stateSize, zero);
+    scratchS2.assign(stateSize, zero);
+    groupMagnitudes.assign(static_cast<size_t>(numGroups), 0.0f);
+
+    maxRampTiles = (juce::jmax(1, maxBlockSize) + tileSize - 1) / tileSize;
+    rampParameters.resize(static_cast<size_t>(maxRampTiles * maxSections));
+    rampTargets.resize(static_cast<size_t>(maxRampTiles * maxSections));
+
+    ids.fill(0);
+    numSections = 0;
+    numDynamicSections = 0;
+    numRampTiles = 0;
+    chainSerial = 0;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::reset()
+{
+    const auto zero = Lanes::expand(0);
+    std::fill(s1.begin(), s1.end(), zero);
+    std::fill(s2.begin(), s2.end(), zero);
+    std::fill(groupMagnitudes.begin(), groupMagnitudes.end(), 0.0f);
+}
+
+template <typename SampleType>
+bool BiquadCascade<SampleType>::isSettled(float threshold) const noexcept
+{
+    for (const auto magnitude : groupMagnitudes)
+        if (magnitude >= threshold)
+            return false;
+
+    return true;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::setChain(const BandChain& chain, float minFrequency, float maxFrequency,
+                                         bool takeDynamicBands) noexcept
+{
+    const auto zero = Lanes::expand(0);
+    int newNumSections = 0;
+    int newNumDynamicSections = 0;
+
+    // State and ramps only carry over within one topology
+    const auto keepsState = topology == loadedTopology;
+    loadedTopology = topology;
+    loadedMinFrequency = minFrequency;
+    loadedMaxFrequency = maxFrequency;
+    loadedDynamicBands = takeDynamicBands;
+    numChainBands = juce::jmin(static_cast<int>(chain.bands.size()), maxSections);
+    chainSections.fill(-1);
+
+    for (size_t index = 0; index < static_cast<size_t>(numChainBands); ++index)
+    {
+        const auto& band = chain.bands[index];
+        const auto section = static_cast<size_t>(newNumSections);
+
+        if (!takesBand(band))
+            continue;
+
+        if (band.isDynamic() || band.morphs)
+        {
+            const auto slot = static_cast<size_t>(newNumDynamicSections++);
+            dynamicChainIndices[slot] = band.isDynamic() ? static_cast<int>(index) : -1;
+            dynamicBands[slot] = band;
+            scratchDynamicSlots[section] = static_cast<int>(slot);
+        }
+        else
+        {
+            scratchDynamicSlots[section] = -1;
+        }
+
+        chainSections[index] = newNumSections;
+        designParameters[section] = band.getParametersAt(morphPosition);
+        designTargets[section] = band.target;
+        scratchIds[section] = band.id;
+        ++newNumSections;
+    }
+
+    designSections(designParameters.data(), designedCoefficients.data(), newNumSections);
+
+    finishRamps();
+    std::fill(scratchS1.begin(), scratchS1.end(), zero);
+    std::fill(scratchS2.begin(), scratchS2.end(), zero);
+    numSharedSections = 0;
+
+    for (int section = 0; section < newNumSections; ++section)
+    {
+        const auto id = scratchIds[static_cast<size_t>(section)];
+        const auto& c = designedCoefficients[static_cast<size_t>(section)];
+        const auto target = designTargets[static_cast<size_t>(section)];
+        const auto slot = scratchDynamicSlots[static_cast<size_t>(section)];
+
+        // Lane 0 is left or mid, lane 1 right or side
+        if (target == ChannelTarget::Stereo)
+        {
+            // The same filter on both lanes works in either representation
+            pairLanes[section] = -1;
+            pairDomains[section] = PairDomain::any;
+            sharedSections[numSharedSections++] = section;
+        }
+        else
+        {
+            pairLanes[section] = (target == ChannelTarget::Left || target == ChannelTarget::Mid) ? 0 : 1;
+            pairDomains[section] = (target == ChannelTarget::Mid || target == ChannelTarget::Side)
+                                       ? PairDomain::midSide : PairDomain::leftRight;
+        }
+
+        setSectionCoefficients(section, c);
+
+        if (slot >= 0)
+            scratchRampStarts[static_cast<size_t>(slot)] = c;
+
+        // Carry over the state of a band that was already running, and for a
+        // dynamic band the design it had ramped to
+        for (int old = 0; keepsState && old < numSections; ++old)
+        {
+            if (ids[old] != id)
+                continue;
+
+            for (int group = 0; group < numGroups; ++group)
+            {
+                const auto from = static_cast<size_t>(group * maxSections + old);
+                const auto to = static_cast<size_t>(group * maxSections + section);
+                scratchS1[to] = s1[from];
+                scratchS2[to] = s2[from];
+            }
+
+            if (slot >= 0 && dynamicSlots[static_cast<size_t>(old)] >= 0)
+                scratchRampStarts[static_cast<size_t>(slot)] = rampStarts[static_cast<size_t>(dynamicSlots[static_cast<size_t>(old)])];
+            break;
+        }
+    }
+
+    std::swap(ids, scratchIds);
+    std::swap(s1, scratchS1);
+    std::swap(s2, scratchS2);
+    std::swap(dynamicSlots, scratchDynamicSlots);
+    std::swap(rampStarts, scratchRampStarts);
+    numSections = newNumSections;
+    numDynamicSections = newNumDynamicSections;
+    chainSerial = chain.serial;
+}
+
+template <typename SampleType>
+bool BiquadCascade<SampleType>::takesBand(const BandChain::Band& band) const noexcept
+{
+    // Flat bands pass everything unchanged, so they don't get a section at all.
+    // Dynamic and morphing bands are only flat for a moment, so they always get one.
+    if (band.isDynamic() || band.morphs)
+        return loadedDynamicBands;
+
+    return !BiquadDesign::isUnity(band.parameters)
+        && band.parameters.frequency >= loadedMinFrequency
+        && band.parameters.frequency < loadedMaxFrequency;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::designSections(const BiquadDesign::Parameters* parameters, Coefficients* results,
+                                               int count) const noexcept
+{
+    if (loadedTopology == FilterTopology::StateVariable)
+        StateVariableDesign::designBatch(parameters, results, count, sampleRate);
+    else
+        BiquadDesign::designBatch(parameters, results, count, sampleRate);
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::setSectionCoefficients(int section, const Coefficients& design) noexcept
+{
+    const auto stateVariable = loadedTopology == FilterTopology::StateVariable;
+    const auto c = stateVariable ? getRunForm(design) : design;
+
+    b0[section] = Lanes::expand(c[0]);
+    b1[section] = Lanes::expand(c[1]);
+    b2[section] = Lanes::expand(c[2]);
+    a1[section] = Lanes::expand(c[3]);
+    a2[section] = Lanes::expand(c[4]);
+
+    Lanes lanes[5];
+    loadLanes(c, stateVariable ? stateVariableRunIdentity<SampleType> : biquadIdentity<SampleType>,
+              pairLanes[section], lanes);
+    pairB0[section] = lanes[0];
+    pairB1[section] = lanes[1];
+    pairB2[section] = lanes[2];
+    pairA1[section] = lanes[3];
+    pairA2[section] = lanes[4];
+}
+
+template <typename SampleType>
+bool BiquadCascade<SampleType>::updateParameters(const BandChain& chain) noexcept
+{
+    if (static_cast<int>(chain.bands.size()) != numChainBands)
+        return false;
+
+    for (int index = 0; index < numChainBands; ++index)
+    {
+        const auto& band = chain.bands[static_cast<size_t>(index)];
+        const auto section = chainSections[static_cast<size_t>(index)];
+
+        if ((section >= 0) != takesBand(band))
+            return false;
+
+        if (section >= 0 && (ids[section] != band.id || designTargets[static_cast<size_t>(section)] != band.target
+                             || (dynamicSlots[static_cast<size_t>(section)] >= 0) != (band.isDynamic() || band.morphs)))
+            return false;
+    }
+
+    std::array<int, maxSections> changedSections;
+    std::array<BiquadDesign::Parameters, maxSections> parameters;
+    std::array<Coefficients, maxSections> coefficients;
+    int numChanged = 0;
+
+    for (int index = 0; index < numChainBands; ++index)
+    {
+        const auto& band = chain.bands[static_cast<size_t>(index)];
+        const auto section = chainSections[static_cast<size_t>(index)];
+
+        if (section < 0)
+            continue;
+
+        if (const auto slot = dynamicSlots[static_cast<size_t>(section)]; slot >= 0)
+        {
+            dynamicBands[static_cast<size_t>(slot)] = band;
+            continue;
+        }
+
+        if (band.parameters == designParameters[static_cast<size_t>(section)])
+            continue;
+
+        designParameters[static_cast<size_t>(section)] = band.parameters;
+        parameters[static_cast<size_t>(numChanged)] = band.parameters;
+        changedSections[static_cast<size_t>(numChanged++)] = section;
+    }
+
+    designSections(parameters.data(), coefficients.data(), numChanged);
+
+    for (int i = 0; i < numChanged; ++i)
+        setSectionCoefficients(changedSections[static_cast<size_t>(i)], coefficients[static_cast<size_t>(i)]);
+
+    return true;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::finishRamps() noexcept
+{
+    if (numRampTiles == 0)
+        return;
+
+    const auto* last = rampTargets.data() + (numRampTiles - 1) * numDynamicSections;
+    std::copy(last, last + numDynamicSections, rampStarts.begin());
+    numRampTiles = 0;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::setModulation(const float* gainChanges, int stride,
+                                              const float* morphPositions, int numTiles) noexcept
+{
+    finishRamps();
+
+    if (numDynamicSections == 0)
+        return;
+
+    numTiles = juce::jmin(numTiles, maxRampTiles);
+
+    for (int tile = 0; tile < numTiles; ++tile)
+    {
+        if (morphPositions != nullptr)
+            morphPosition = morphPositions[tile];
+
+        for (int slot = 0; slot < numDynamicSections; ++slot)
+        {
+            auto& parameters = rampParameters[static_cast<size_t>(tile * numDynamicSections + slot)];
+            parameters = dynamicBands[static_cast<size_t>(slot)].getParametersAt(morphPosition);
+
+            const auto chainIndex = dynamicChainIndices[static_cast<size_t>(slot)];
+
+            if (gainChanges != nullptr && chainIndex >= 0)
+                parameters.gain += gainChanges[tile * stride + chainIndex];
+        }
+    }
+
+    // Every tile of every dynamic section in one batch
+    designSections(rampParameters.data(), rampTargets.data(), numTiles * numDynamicSections);
+    numRampTiles = numTiles;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::process(juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::process(SampleType* const* channelData, int bufferChannels, int numSamples) noexcept
+{
+    processGroups(channelData, bufferChannels, numSamples, 0, numGroups);
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::processGroups(SampleType* const* channelData, int bufferChannels, int numSamples,
+                                              int firstGroup, int endGroup) noexcept
+{
+    const auto channels = juce::jmin(bufferChannels, numChannels);
+    endGroup = juce::jmin(endGroup, numGroups);
+
+    for (int group = firstGroup; group < endGroup; ++group)
+    {
+        const auto firstChannel = group * numLanes;
+        const auto numActive = juce::jmin(numLanes, channels - firstChannel);
+        auto& magnitude = groupMagnitudes[static_cast<size_t>(group)];
+
+        if (numSections == 0 || numActive <= 0)
+        {
+            magnitude = 0.0f;
+            continue;
+        }
+
+        const auto offset = static_cast<size_t>(group * maxSections);
+        magnitude = processGroup(channelData + firstChannel, numActive, numSamples,
+                                 s1.data() + offset, s2.data() + offset, group == 0);
+    }
+}
+
+template <typename SampleType>
+float BiquadCascade<SampleType>::processGroup(SampleType* const* channels, int numActive, int numSamples,
+                                              Lanes* state1, Lanes* state2, bool holdsPair) const noexcept
+{
+    // Interleaved tile: sample i of lane l lives at tile[i * numLanes + l].
+    // Unused lanes stay at zero and decay harmlessly.
+    alignas(64) SampleType tile[tileSize * numLanes] = {};
+
+    // A lone channel is its own mid and has no side, so it is never converted
+    const auto canConvertPair = holdsPair && numActive >= 2;
+
+    for (int start = 0; start < numSamples; start += tileSize)
+    {
+        const auto tileLength = juce::jmin(tileSize, numSamples - start);
+
+        for (int lane = 0; lane < numActive; ++lane)
+        {
+            const auto* src = channels[lane] + start;
+            for (int i = 0; i < tileLength; ++i)
+                tile[i * numLanes + lane] = src[i];
+        }
+
+        // Every section runs over the tile while it is still hot in L1
+        if (holdsPair)
+        {
+            auto domain = PairDomain::leftRight;
+
+            for (int section = 0; section < numSections; ++section)
+            {
+                const auto wanted = pairDomains[section];
+
+                if (canConvertPair && wanted != PairDomain::any && wanted != domain)
+                {
+                    convertPair(tile, tileLength, wanted == PairDomain::midSide);
+                    domain = wanted;
+                }
+
+                if (dynamicSlots[static_cast<size_t>(section)] >= 0)
+                    runDynamicSection(tile, tileLength, start / tileSize, section, true,
+                                      state1[section], state2[section]);
+                else
+                    runStaticSection(tile, tileLength, section, true, state1[section], state2[section]);
+            }
+
+            if (domain == PairDomain::midSide)
+                convertPair(tile, tileLength, false);
+        }
+        else
+        {
+            for (int i = 0; i < numSharedSections; ++i)
+            {
+                const auto section = sharedSections[static_cast<size_t>(i)];
+
+                if (dynamicSlots[static_cast<size_t>(section)] >= 0)
+                    runDynamicSection(tile, tileLength, start / tileSize, section, false,
+                                      state1[section], state2[section]);
+                else
+                    runStaticSection(tile, tileLength, section, false, state1[section], state2[section]);
+            }
+        }
+
+        for (int lane = 0; lane < numActive; ++lane)
+        {
+            auto* dest = channels[lane] + start;
+            for (int i = 0; i < tileLength; ++i)
+                dest[i] = tile[i * numLanes + lane];
+        }
+    }
+
+    // Flush denormal-range state, as juce::dsp::IIR::Filter does after each block,
+    // and note how much energy is left so the processor can tell when it may sleep
+    auto magnitude = 0.0f;
+
+    for (int section = 0; section < numSections; ++section)
+    {
+        alignas(64) SampleType z[2][numLanes];
+        state1[section].copyToRawArray(z[0]);
+        state2[section].copyToRawArray(z[1]);
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            JUCE_SNAP_TO_ZERO(z[0][lane]);
+            JUCE_SNAP_TO_ZERO(z[1][lane]);
+            magnitude = juce::jmax(magnitude, static_cast<float>(std::abs(z[0][lane])),
+                                   static_cast<float>(std::abs(z[1][lane])));
+        }
+
+        state1[section] = Lanes::fromRawArray(z[0]);
+        state2[section] = Lanes::fromRawArray(z[1]);
+    }
+
+    return magnitude;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::runStaticSection(SampleType* tile, int tileLength, int section, bool holdsPair,
+                                                 Lanes& state1, Lanes& state2) const noexcept
+{
+    const auto& c0 = holdsPair ? pairB0 : b0;
+    const auto& c1 = holdsPair ? pairB1 : b1;
+    const auto& c2 = holdsPair ? pairB2 : b2;
+    const auto& d1 = holdsPair ? pairA1 : a1;
+    const auto& d2 = holdsPair ? pairA2 : a2;
+
+    if (loadedTopology == FilterTopology::StateVariable)
+        runStateVariableSection(tile, tileLength, c0[section], c1[section], c2[section], d1[section], d2[section],
+                                state1, state2);
+    else
+        runSection(tile, tileLength, c0[section], c1[section], c2[section], d1[section], d2[section],
+                   state1, state2);
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::runDynamicSection(SampleType* tile, int tileLength, int tileIndex, int section,
+                                                  bool holdsPair, Lanes& state1, Lanes& state2) const noexcept
+{
+    const auto slot = dynamicSlots[static_cast<size_t>(section)];
+    const auto lane = holdsPair ? pairLanes[static_cast<size_t>(section)] : -1;
+    const auto designAt = [this, slot](int tile) -> const Coefficients&
+    {
+        return tile < 0 ? rampStarts[static_cast<size_t>(slot)]
+                        : rampTargets[static_cast<size_t>(tile * numDynamicSections + slot)];
+    };
+
+    const auto& last = designAt(juce::jmin(tileIndex, numRampTiles - 1));
+    Lanes to[5], from[5];
+
+    if (loadedTopology == FilterTopology::StateVariable)
+    {
+        // Past the last designed tile the band holds its final design
+        if (tileIndex >= numRampTiles)
+        {
+            loadLanes(getRunForm(last), stateVariableRunIdentity<SampleType>, lane, to);
+            runStateVariableSection(tile, tileLength, to[0], to[1], to[2], to[3], to[4], state1, state2);
+            return;
+        }
+
+        loadLanes(last, stateVariableIdentity<SampleType>, lane, to);
+        loadLanes(designAt(tileIndex - 1), stateVariableIdentity<SampleType>, lane, from);
+        runRampedStateVariableSection(tile, tileLength, from, to, state1, state2);
+        return;
+    }
+
+    // Past the last designed tile the band holds its final design
+    loadLanes(last, biquadIdentity<SampleType>, lane, to);
+
+    if (tileIndex >= numRampTiles)
+    {
+        runSection(tile, tileLength, to[0], to[1], to[2], to[3], to[4], state1, state2);
+        return;
+    }
+
+    loadLanes(designAt(tileIndex - 1), biquadIdentity<SampleType>, lane, from);
+    runRampedSection(tile, tileLength, from, to, state1, state2);
+}
+
+template class BiquadCascade<float>;
+template class BiquadCascade<double>;
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <limits>
+#include <vector>
+#include "BandChain.h"
+#include "BiquadDesign.h"
+#include "StateVariableDesign.h"
+
+#if JUCE_USE_SIMD
+ template <typename SampleType>
+ using LaneVector = juce::dsp::SIMDRegister<SampleType>;
+#else
+ /** Two-lane scalar stand-in for juce::dsp::SIMDRegister on targets without
+     SIMD. Two lanes keep a stereo pair in one group, as on every SIMD target.
+ */
+ template <typename SampleType>
+ struct LaneVector
+ {
+     static constexpr size_t SIMDNumElements = 2;
+     static constexpr size_t size() noexcept { return 2; }
+
+     static LaneVector expand(SampleType v) noexcept              { return { { v, v } }; }
+     static LaneVector fromRawArray(const SampleType* p) noexcept { return { { p[0], p[1] } }; }
+     void copyToRawArray(SampleType* p) const noexcept            { p[0] = value[0]; p[1] = value[1]; }
+
+     LaneVector operator+(LaneVector o) const noexcept { return { { value[0] + o.value[0], value[1] + o.value[1] } }; }
+     LaneVector operator-(LaneVector o) const noexcept { return { { value[0] - o.value[0], value[1] - o.value[1] } }; }
+     LaneVector operator*(LaneVector o) const noexcept { return { { value[0] * o.value[0], value[1] * o.value[1] } }; }
+
+     SampleType value[2];
+ };
+#endif
+
+/** Runs every section of a BandChain over the buffer in a single pass.
+
+    Channels are packed into SIMD lanes (four floats or two doubles per
+    register with SSE/NEON), so one biquad recurrence advances a whole group
+    of channels at once; in float, stereo is a single group, 7.1.4 is three
+    and 16-channel Ambisonics is four.
+    Coefficients and state for all sections are kept in contiguous arrays.
+    Each channel group is walked in short tiles that stay in L1 while every
+    active section runs over them, so the audio buffer is read and written
+    once per block regardless of how many bands there are. The arithmetic per
+    section is the same transposed direct form II as juce::dsp::IIR::Filter,
+    so the output matches running the sections one after the other.
+
+    Bands aimed at part of the stereo pair (see ChannelTarget) only run in
+    the group that holds the first two channels, with per-lane coefficients
+    that pass the lanes they don't target unchanged. Mid and side sections
+    run with the pair's lanes converted to mid/side inside the tile; the
+    conversion happens once per run of such sections, and not at all for a
+    chain without them. Every other group skips targeted sections, so plain
+    stereo bands cost exactly what they did.
+
+    Dynamic bands (see BandDynamics) get a gain change per tile, and bands
+    morphing between snapshots a morph position per tile, from
+    setModulation(). Their coefficients are designed once per tile, in one
+    batch for the whole block, and ramp linearly across the tile from the
+    previous design to the next, so gain and morph move without zipper
+    noise and nothing is designed per sample. The morph itself interpolates
+    frequency, gain and Q (see BiquadDesign::interpolate), never the
+    coefficients, so every design along the way is stable.
+
+    Sections are biquads by default. With FilterTopology::StateVariable
+    every section is a trapezoidal state-variable filter instead (see
+    StateVariableDesign), with the same response and the same lanes, tiles
+    and pair handling. Dynamic and morphing sections then move every
+    sample: the designs per tile are interpolated sample by sample, which
+    for this topology is stable at any speed. Static sections take their
+    automation steps without the transient a biquad makes. It costs a few
+    more operations per sample, plus a division per sample and lane while
+    a section ramps.
+
+    SampleType is float or double. The double cascade keeps double state and
+    coefficients throughout, which low, high-Q bands at high sample rates
+    need: their poles sit so close to the unit circle that float rounding
+    moves them audibly.
+*/
+template <typename SampleType>
+class BiquadCascade
+{
+public:
+    using Lanes = LaneVector<SampleType>;
+    using Coefficients = BiquadDesign::CoefficientsOf<SampleType>;
+
+    static constexpr int maxSections = BandChain::maxBands;
+    static constexpr int tileSize = 64;
+    static constexpr int numLanes = static_cast<int>(Lanes::SIMDNumElements);
+    static_assert(numLanes >= 2, "the stereo pair must share a group");
+
+    BiquadCascade() = default;
+
+    /** Allocates state for numChannels channels running at sampleRate, in blocks
+        of up to maxBlockSize samples. Not realtime safe.
+    */
+    void prepare(double sampleRate, int numChannels, int maxBlockSize);
+    void reset();
+
+    /** Changes the rate sections are designed for, e.g. when the cascade moves
+        behind an oversampler. Takes effect at the next setChain(); realtime safe.
+    */
+    void setSampleRate(double newSampleRate) noexcept { sampleRate = newSampleRate; }
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    /** Chooses how sections are realised. Takes effect at the next setChain(),
+        which starts every section from silence if the topology changed, as
+        the state of one doesn't carry over to the other. Realtime safe.
+    */
+    void setTopology(FilterTopology newTopology) noexcept { topology = newTopology; }
+
+    /** The topology the loaded sections run in. */
+    FilterTopology getTopology() const noexcept { return loadedTopology; }
+
+    /** Loads the sections of a new chain, keeping the state of bands that survive.
+        Only bands with minFrequency <= frequency < maxFrequency are taken, so a
+        chain can be split between cascades running at different rates.
+        Dynamic and morphing bands ignore the range and are taken only if
+        takeDynamicBands is set, as their modulation arrives at this cascade's
+        control rate.
+        Coefficients for all sections are designed in one batched call, without allocating.
+    */
+    void setChain(const BandChain& chain,
+                  float minFrequency = 0.0f,
+                  float maxFrequency = std::numeric_limits<float>::max(),
+                  bool takeDynamicBands = true) noexcept;
+    juce::uint64 getChainSerial() const noexcept { return chainSerial; }
+
+    /** Takes new parameters for the bands of the chain last loaded, the cheap
+        path for automation: only sections whose parameters changed are
+        redesigned, in one batch, in place and keeping their state. Dynamic
+        and morphing bands take theirs at the next setModulation(). Returns
+        false, changing nothing, if the chain no longer fits the loaded
+        sections (a band turning flat or back, leaving the frequency range,
+        changing its channels or starting to move), which needs setChain().
+    */
+    bool updateParameters(const BandChain& chain) noexcept;
+
+    /** Number of sections actually run; flat (0 dB) bands are skipped entirely. */
+    int getNumSections() const noexcept { return numSections; }
+    int getNumDynamicSections() const noexcept { return numDynamicSections; }
+
+    /** Modulation of the dynamic and morphing bands for the next block, one
+        value per tile: gain changes in dB laid out as
+        gainChanges[tile * stride + chain band index], and morph positions.
+        Either may be null, for no gain change or a morph held where it is.
+        Call once per block before processing it; tiles past numTiles keep
+        the last design.
+    */
+    void setModulation(const float* gainChanges, int stride, const float* morphPositions, int numTiles) noexcept;
+
+    /** The morph position designs start from at the next setChain(), e.g.
+        when a chain starts morphing part of the way along. Realtime safe.
+    */
+    void setMorphPosition(float newPosition) noexcept { morphPosition = newPosition; }
+
+    void process(juce::AudioBuffer<SampleType>& buffer) noexcept;
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Channel groups share nothing while processing, so a block can be split
+        into disjoint ranges of groups [firstGroup, endGroup) that run on
+        different threads. process() is every group on the calling thread.
+    */
+    int getNumGroups() const noexcept { return numGroups; }
+    void processGroups(SampleType* const* channels, int numChannels, int numSamples,
+                       int firstGroup, int endGroup) noexcept;
+
+    /** True once every section's state has decayed below threshold after the last block. */
+    bool isSettled(float threshold) const noexcept;
+
+private:
+    double sampleRate = 44100.0;
+    int numChannels = 0;
+    int numGroups = 0;
+    int numSections = 0;
+    juce::uint64 chainSerial = 0;
+
+    FilterTopology topology = FilterTopology::Biquad, loadedTopology = FilterTopology::Biquad;
+
+    // Structure-of-arrays coefficients, one lane vector per section. For
+    // state-variable sections these hold g, 1 / (1 + g (g + k)), m0, m1 and
+    // m2, so running a static section takes no division.
+    std::array<Lanes, maxSections> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+
+    // The same per lane for the group holding the stereo pair, where
+    // targeted sections pass the lanes they leave alone
+    std::array<Lanes, maxSections> pairB0 {}, pairB1 {}, pairB2 {}, pairA1 {}, pairA2 {};
+
+    // The section of each band of the loaded chain (-1 for none), and the
+    // range and kind of bands it was loaded with
+    std::array<int, maxSections> chainSections {};
+    int numChainBands = 0;
+    float loadedMinFrequency = 0.0f;
+    float loadedMaxFrequency = 0.0f;
+    bool loadedDynamicBands = true;
+
+    bool takesBand(const BandChain::Band& band) const noexcept;
+    void setSectionCoefficients(int section, const Coefficients& design) noexcept;
+
+    /** Designs for the topology being loaded: biquad coefficients or g, k, m0, m1, m2. */
+    void designSections(const BiquadDesign::Parameters* parameters, Coefficients* results, int count) const noexcept;
+
+    // Which representation of the pair each section needs in that group
+    enum class PairDomain { any, leftRight, midSide };
+    std::array<PairDomain, maxSections> pairDomains {};
+    std::array<ChannelTarget, maxSections> designTargets {};
+
+    // The lane a targeted section acts on in that group, or -1 for every lane
+    std::array<int, maxSections> pairLanes {};
+
+    // Sections every other group runs: everything but the targeted ones
+    std::array<int, maxSections> sharedSections {};
+    int numSharedSections = 0;
+
+    // Dynamic sections, designed per tile: dynamic and morphing bands. Each
+    // section's slot (-1 if static) and, per slot, the chain band its gain
+    // changes belong to (-1 if it only morphs) and a copy of that band
+    std::array<int, maxSections> dynamicSlots {}, scratchDynamicSlots {};
+    std::array<int, maxSections> dynamicChainIndices {};
+    std::array<BandChain::Band, maxSections> dynamicBands {};
+    int numDynamicSections = 0;
+    float morphPosition = 0.0f;
+
+    // Where each slot's ramp starts in the next block, then its designs for
+    // every tile of the current one as [tile * numDynamicSections + slot]
+    std::array<Coefficients, maxSections> rampStarts {}, scratchRampStarts {};
+    std::vector<BiquadDesign::Parameters> rampParameters;
+    std::vector<Coefficients> rampTargets;
+    int maxRampTiles = 0;
+    int numRampTiles = 0;
+    std::array<juce::uint32, maxSections> ids {}, scratchIds {};
+    std::array<BiquadDesign::Parameters, maxSections> designParameters {};
+    std::array<Coefficients, maxSections> designedCoefficients {};
+
+    // State laid out as [group][section], so one group's sections are contiguous
+    std::vector<Lanes> s1, s2, scratchS1, scratchS2;
+
+    // Largest state left in each group after its last block
+    std::vector<float> groupMagnitudes;
+
+    float processGroup(SampleType* const* channels, int numActive, int numSamples,
+                       Lanes* state1, Lanes* state2, bool holdsPair) const noexcept;
+
+    /** Runs a static section over one tile. */
+    void runStaticSection(SampleType* tile, int tileLength, int section, bool holdsPair,
+                          Lanes& state1, Lanes& state2) const noexcept;
+
+    /** Runs a dynamic section over one tile, ramping between its designs. */
+    void runDynamicSection(SampleType* tile, int tileLength, int tileIndex, int section,
+                           bool holdsPair, Lanes& state1, Lanes& state2) const noexcept;
+
+    /** The last block's final designs become the next block's starting points. */
+    void finishRamps() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE(BiquadCascade)
+};
@@ -0,0 +1,242 @@
+#include "BiquadDesign.h"
+#include <cmath>
+#include <limits>
+
+namespace BiquadDesign
+{
+
+namespace
+{
+    constexpr int batchSize = 16;
+
+    double clampFrequency(float frequency, double sampleRate) noexcept
+    {
+        // JUCE clamps shelves and peaks at 2 Hz; stay clear of Nyquist so sin(w) never vanishes
+        return juce::jlimit(2.0, sampleRate * 0.499, static_cast<double>(frequency));
+    }
+
+    /** Designs one band from the shared trig terms of w = 2 pi f / fs. */
+    template <typename SampleType>
+    void designFromTrig(const Parameters& p, double sinW, double cosW, CoefficientsOf<SampleType>& result) noexcept
+    {
+        const auto q = juce::jmax(0.001, static_cast<double>(p.q));
+        double b0, b1, b2, a0, a1, a2;
+
+        switch (p.type)
+        {
+            case FilterType::LowPass:
+            case FilterType::HighPass:
+            case FilterType::Notch:
+            {
+                // n = 1 / tan(w / 2), written in terms of sin and cos
+                const auto n = (1.0 + cosW) / sinW;
+                const auto nSquared = n * n;
+                const auto invQ = 1.0 / q;
+
+                a0 = 1.0 + invQ * n + nSquared;
+                a1 = 2.0 * (1.0 - nSquared);
+                a2 = 1.0 - invQ * n + nSquared;
+
+                if (p.type == FilterType::LowPass)
+                {
+                    b0 = 1.0; b1 = 2.0; b2 = 1.0;
+                }
+                else if (p.type == FilterType::HighPass)
+                {
+                    b0 = nSquared; b1 = -2.0 * nSquared; b2 = nSquared;
+                }
+                else
+                {
+                    b0 = 1.0 + nSquared; b1 = a1; b2 = b0;
+                }
+                break;
+            }
+
+            case FilterType::Peak:
+            {
+                const auto A = std::pow(10.0, p.gain / 40.0);
+                const auto alpha = sinW / (q * 2.0);
+                const auto c2 = -2.0 * cosW;
+
+                b0 = 1.0 + alpha * A;  b1 = c2;  b2 = 1.0 - alpha * A;
+                a0 = 1.0 + alpha / A;  a1 = c2;  a2 = 1.0 - alpha / A;
+                break;
+            }
+
+            case FilterType::LowShelf:
+            case FilterType::HighShelf:
+            default:
+            {
+                const auto A = std::pow(10.0, p.gain / 40.0);
+                const auto aMinus1 = A - 1.0;
+                const auto aPlus1 = A + 1.0;
+                const auto beta = sinW * std::sqrt(A) / q;
+                const auto aMinus1TimesCos = aMinus1 * cosW;
+
+                if (p.type == FilterType::LowShelf)
+                {
+                    b0 = A * (aPlus1 - aMinus1TimesCos + beta);
+                    b1 = A * 2.0 * (aMinus1 - aPlus1 * cosW);
+                    b2 = A * (aPlus1 - aMinus1TimesCos - beta);
+                    a0 = aPlus1 + aMinus1TimesCos + beta;
+                    a1 = -2.0 * (aMinus1 + aPlus1 * cosW);
+                    a2 = aPlus1 + aMinus1TimesCos - beta;
+                }
+                else
+                {
+                    b0 = A * (aPlus1 + aMinus1TimesCos + beta);
+                    b1 = A * -2.0 * (aMinus1 + aPlus1 * cosW);
+                    b2 = A * (aPlus1 + aMinus1TimesCos - beta);
+                    a0 = aPlus1 - aMinus1TimesCos + beta;
+                    a1 = 2.0 * (aMinus1 - aPlus1 * cosW);
+                    a2 = aPlus1 - aMinus1TimesCos - beta;
+                }
+                break;
+            }
+        }
+
+        const auto invA0 = 1.0 / a0;
+        result = { static_cast<SampleType>(b0 * invA0), static_cast<SampleType>(b1 * invA0),
+                   static_cast<SampleType>(b2 * invA0), static_cast<SampleType>(a1 * invA0),
+                   static_cast<SampleType>(a2 * invA0) };
+    }
+}
+
+template <typename SampleType>
+void design(const Parameters& parameters, double sampleRate, CoefficientsOf<SampleType>& result) noexcept
+{
+    const auto w = juce::MathConstants<double>::twoPi * clampFrequency(parameters.frequency, sampleRate) / sampleRate;
+    designFromTrig(parameters, std::sin(w), std::cos(w), result);
+}
+
+template <typename SampleType>
+void designBatch(const Parameters* parameters, CoefficientsOf<SampleType>* results,
+                 int numBands, double sampleRate) noexcept
+{
+    const auto radiansPerHz = juce::MathConstants<double>::twoPi / sampleRate;
+
+    // Work in fixed-size chunks on the stack so any number of bands can be
+    // designed without touching the heap. The trig pass runs over plain
+    // arrays, which lets the compiler use its vector math routines.
+    for (int start = 0; start < numBands; start += batchSize)
+    {
+        const auto count = juce::jmin(batchSize, numBands - start);
+        double sinW[batchSize], cosW[batchSize];
+
+        for (int i = 0; i < count; ++i)
+        {
+            const auto w = radiansPerHz * clampFrequency(parameters[start + i].frequency, sampleRate);
+            sinW[i] = std::sin(w);
+            cosW[i] = std::cos(w);
+        }
+
+        for (int i = 0; i < count; ++i)
+            designFromTrig(parameters[start + i], sinW[i], cosW[i], results[start + i]);
+    }
+}
+
+template void design<float>(const Parameters&, double, CoefficientsOf<float>&) noexcept;
+template void design<double>(const Parameters&, double, CoefficientsOf<double>&) noexcept;
+template void designBatch<float>(const Parameters*, CoefficientsOf<float>*, int, double) noexcept;
+template void designBatch<double>(const Parameters*, CoefficientsOf<double>*, int, double) noexcept;
+
+void designBandPass(float frequency, float q, double sampleRate, Coefficients& result) noexcept
+{
+    const auto w = juce::MathConstants<double>::twoPi * clampFrequency(frequency, sampleRate) / sampleRate;
+    const auto alpha = std::sin(w) / (juce::jmax(0.001, static_cast<double>(q)) * 2.0);
+    const auto invA0 = 1.0 / (1.0 + alpha);
+
+    result = { static_cast<float>(alpha * invA0), 0.0f, static_cast<float>(-alpha * invA0),
+               static_cast<float>(-2.0 * std::cos(w) * invA0), static_cast<float>((1.0 - alpha) * invA0) };
+}
+
+Parameters interpolate(const Parameters& a, const Parameters& b, float t) noexcept
+{
+    const auto geometric = [t](float from, float to)
+    {
+        // Guards the logarithm; designs clamp far above this anyway
+        from = juce::jmax(1.0e-3f, from);
+        to = juce::jmax(1.0e-3f, to);
+        return from * std::exp(t * std::log(to / from));
+    };
+
+    Parameters result;
+    result.type = a.type;
+    result.frequency = geometric(a.frequency, b.frequency);
+    result.gain = a.gain + t * (b.gain - a.gain);
+    result.q = geometric(a.q, b.q);
+    return result;
+}
+
+bool isUnity(const Parameters& parameters) noexcept
+{
+    switch (parameters.type)
+    {
+        case FilterType::Peak:
+        case FilterType::LowShelf:
+        case FilterType::HighShelf:
+            return std::abs(parameters.gain) < 0.01f;
+
+        case FilterType::Notch:
+        case FilterType::LowPass:
+        case FilterType::HighPass:
+        default:
+            return false;
+    }
+}
+
+double getPoleRadius(const Coefficients& coefficients) noexcept
+{
+    // Poles are the roots of z^2 + a1 z + a2
+    const auto a1 = static_cast<double>(coefficients[3]);
+    const auto a2 = static_cast<double>(coefficients[4]);
+    const auto discriminant = a1 * a1 - 4.0 * a2;
+
+    if (discriminant < 0.0)
+        return std::sqrt(a2);   // complex pair, |p|^2 = a2
+
+    const auto root = std::sqrt(discriminant);
+    return juce::jmax(std::abs(-a1 + root), std::abs(-a1 - root)) * 0.5;
+}
+
+double getDecaySamples(const Coefficients& coefficients, double attenuationDb) noexcept
+{
+    const auto radius = getPoleRadius(coefficients);
+
+    if (radius <= 0.0)
+        return 2.0;     // FIR: done after the last tap
+
+    if (radius >= 1.0)
+        return std::numeric_limits<double>::infinity();
+
+    return (-attenuationDb / 20.0) * std::log(10.0) / std::log(radius);
+}
+
+void getMagnitudeResponseDb(const Coefficients& c, const float* phi,
+                            float* decibels, int numPoints) noexcept
+{
+    // |H(e^jw)|^2 in terms of phi = sin^2(w/2), which stays accurate in float
+    // at low frequencies where the cos(w) form cancels:
+    // |P|^2 = (p0 + p1 + p2)^2 - 4 (p0 p1 + 4 p0 p2 + p1 p2) phi + 16 p0 p2 phi^2
+    const auto bSum = c[0] + c[1] + c[2];
+    const auto n0 = bSum * bSum;
+    const auto n1 = -4.0f * (c[0] * c[1] + 4.0f * c[0] * c[2] + c[1] * c[2]);
+    const auto n2 = 16.0f * c[0] * c[2];
+
+    const auto aSum = 1.0f + c[3] + c[4];
+    const auto d0 = aSum * aSum;
+    const auto d1 = -4.0f * (c[3] + 4.0f * c[4] + c[3] * c[4]);
+    const auto d2 = 16.0f * c[4];
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const auto numerator = n0 + (n1 + n2 * phi[i]) * phi[i];
+        const auto denominator = d0 + (d1 + d2 * phi[i]) * phi[i];
+        decibels[i] = juce::jmax(1.0e-12f, numerator) / denominator;
+    }
+
+    for (int i = 0; i < numPoints; ++i)
+        decibels[i] = 10.0f * std::log10(decibels[i]);
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+enum class FilterType
+{
+    LowShelf,
+    HighShelf,
+    Peak,
+    Notch,
+    LowPass,
+    HighPass
+};
+
+/** Allocation-free biquad design.
+
+    Produces the same responses as juce::dsp::IIR::Coefficients<float>::make*,
+    but writes straight into caller-owned storage instead of heap-allocating a
+    ref-counted coefficients object, so it is safe to call from the audio
+    thread. The batched version evaluates one sin/cos pair per band and
+    derives every other trig term from it.
+*/
+namespace BiquadDesign
+{
+    struct Parameters
+    {
+        FilterType type = FilterType::Peak;
+        float frequency = 1000.0f;
+        float gain = 0.0f;      // dB, ignored by Notch/LowPass/HighPass
+        float q = 1.0f;
+
+        bool operator==(const Parameters& other) const noexcept
+        {
+            return type == other.type && frequency == other.frequency && gain == other.gain && q == other.q;
+        }
+
+        bool operator!=(const Parameters& other) const noexcept { return !(*this == other); }
+    };
+
+    // Normalised by a0: b0, b1, b2, a1, a2
+    template <typename SampleType>
+    using CoefficientsOf = std::array<SampleType, 5>;
+    using Coefficients = CoefficientsOf<float>;
+
+    /** Designs in double and rounds once to the sample type (float or double),
+        so a double-precision cascade keeps the exact poles of low, narrow bands.
+    */
+    template <typename SampleType>
+    void design(const Parameters& parameters, double sampleRate, CoefficientsOf<SampleType>& result) noexcept;
+
+    template <typename SampleType>
+    void designBatch(const Parameters* parameters, CoefficientsOf<SampleType>* results,
+                     int numBands, double sampleRate) noexcept;
+
+    /** Band-pass with 0 dB at the centre frequency, for detecting a band's level. */
+    void designBandPass(float frequency, float q, double sampleRate, Coefficients& result) noexcept;
+
+    /** Settings a fraction t of the way from a to b, which share a type.
+        Frequency and Q move geometrically and gain linearly in dB, so every
+        point along the way is a well-formed band and its design is stable,
+        unlike interpolating the coefficients themselves. Realtime safe.
+    */
+    Parameters interpolate(const Parameters& a, const Parameters& b, float t) noexcept;
+
+    /** True for designs that pass everything unchanged (0 dB peaks and shelves). */
+    bool isUnity(const Parameters& parameters) noexcept;
+
+    /** Magnitude of the largest pole; anything below 1 is stable. */
+    double getPoleRadius(const Coefficients& coefficients) noexcept;
+
+    /** Samples until the impulse response has decayed by attenuationDb. */
+    double getDecaySamples(const Coefficients& coefficients, double attenuationDb) noexcept;
+
+    /** Exact magnitude response in dB at each point of a frequency grid, given
+        phi = sin^2(w / 2) for every point. The polynomial part runs as one
+        straight loop over the arrays so it vectorizes.
+    */
+    void getMagnitudeResponseDb(const Coefficients& coefficients, const float* phi,
+                                float* decibels, int numPoints) noexcept;
+}
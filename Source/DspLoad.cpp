@@ -0,0 +1,66 @@
+#include "DspLoad.h"
+
+double DspLoadStatistics::getAverageLoad() const noexcept
+{
+    const auto audioSeconds = sampleRate > 0.0 ? static_cast<double>(numSamples) / sampleRate : 0.0;
+    return audioSeconds > 0.0 ? busySeconds / audioSeconds : 0.0;
+}
+
+double DspLoadStatistics::getLoadSince(const DspLoadStatistics& earlier) const noexcept
+{
+    // A reset in between leaves nothing to compare against
+    if (numSamples <= earlier.numSamples || sampleRate <= 0.0)
+        return 0.0;
+
+    const auto audioSeconds = static_cast<double>(numSamples - earlier.numSamples) / sampleRate;
+    return juce::jmax(0.0, busySeconds - earlier.busySeconds) / audioSeconds;
+}
+
+DspLoadMonitor::DspLoadMonitor()
+    : ticksPerSecond(static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()))
+{
+    prepare(44100.0);
+}
+
+void DspLoadMonitor::prepare(double newSampleRate)
+{
+    sampleRate.store(newSampleRate, std::memory_order_relaxed);
+    ticksPerSample = ticksPerSecond / newSampleRate;
+    clear();
+}
+
+void DspLoadMonitor::clear() noexcept
+{
+    resetRequested.store(false, std::memory_order_relaxed);
+
+    for (auto& bin : histogram)
+        bin.store(0, std::memory_order_relaxed);
+
+    for (auto* counter : { &numBlocks, &missedDeadlines, &numSamplesProcessed,
+                           &busyTicksTotal, &bandTicksTotal, &analyzerTicksTotal })
+        counter->store(0, std::memory_order_relaxed);
+
+    worstBlockTicks.store(0, std::memory_order_relaxed);
+    worstLoad.store(0.0, std::memory_order_relaxed);
+}
+
+DspLoadStatistics DspLoadMonitor::getStatistics() const noexcept
+{
+    DspLoadStatistics statistics;
+
+    for (size_t i = 0; i < histogram.size(); ++i)
+        statistics.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+
+    const auto toSeconds = [this](juce::uint64 ticks) { return static_cast<double>(ticks) / ticksPerSecond; };
+
+    statistics.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    statistics.missedDeadlines = missedDeadlines.load(std::memory_order_relaxed);
+    statistics.numSamples = numSamplesProcessed.load(std::memory_order_relaxed);
+    statistics.sampleRate = sampleRate.load(std::memory_order_relaxed);
+    statistics.busySeconds = toSeconds(busyTicksTotal.load(std::memory_order_relaxed));
+    statistics.bandSeconds = toSeconds(bandTicksTotal.load(std::memory_order_relaxed));
+    statistics.analyzerSeconds = toSeconds(analyzerTicksTotal.load(std::memory_order_relaxed));
+    statistics.worstBlockSeconds = toSeconds(static_cast<juce::uint64>(worstBlockTicks.load(std::memory_order_relaxed)));
+    statistics.worstLoad = worstLoad.load(std::memory_order_relaxed);
+    return statistics;
+}
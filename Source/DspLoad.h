@@ -0,0 +1,118 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/** A snapshot of DspLoadMonitor's counters. Everything is cumulative since
+    the last reset, so the load over any interval is the difference between
+    two snapshots (see getLoadSince).
+*/
+struct DspLoadStatistics
+{
+    // 5% wide bins of load (time spent / real-time budget) from 0 to 100%;
+    // the last bin counts every block that overran its budget
+    static constexpr int numHistogramBins = 21;
+    std::array<juce::uint64, numHistogramBins> histogram {};
+
+    juce::uint64 numBlocks = 0;
+    juce::uint64 missedDeadlines = 0;
+    juce::uint64 numSamples = 0;
+    double sampleRate = 0.0;
+
+    double busySeconds = 0.0;       // whole of processBlock
+    double bandSeconds = 0.0;       // the filter stage: cascades, oversampling or convolution
+    double analyzerSeconds = 0.0;   // handing the block to the analysis thread
+    double worstBlockSeconds = 0.0;
+    double worstLoad = 0.0;
+
+    /** Busy time over audio time since the reset; 1 means the whole budget. */
+    double getAverageLoad() const noexcept;
+
+    /** Load between an earlier snapshot and this one. */
+    double getLoadSince(const DspLoadStatistics& earlier) const noexcept;
+
+    double getBandShare() const noexcept     { return busySeconds > 0.0 ? bandSeconds / busySeconds : 0.0; }
+    double getAnalyzerShare() const noexcept { return busySeconds > 0.0 ? analyzerSeconds / busySeconds : 0.0; }
+};
+
+/** Per-instance timing of processBlock against each block's real-time budget.
+
+    The audio thread reads the high-resolution clock three times per block
+    (start, end of the filter stage, end) and calls record(); it is the only
+    writer, so every counter is a plain relaxed load and store, with no
+    read-modify-write and no locks. Any thread can take a snapshot. Fields of
+    a snapshot may be a block apart from each other, which is fine for
+    statistics. Resets are requested and carried out by the audio thread, so
+    they never race with it.
+*/
+class DspLoadMonitor
+{
+public:
+    DspLoadMonitor();
+
+    /** Call from prepareToPlay, before processing starts; also resets. */
+    void prepare(double sampleRate);
+
+    /** Any thread: clears the counters at the start of the next block. */
+    void requestReset() noexcept { resetRequested.store(true, std::memory_order_relaxed); }
+
+    /** Any thread. */
+    DspLoadStatistics getStatistics() const noexcept;
+
+    static juce::int64 now() noexcept { return juce::Time::getHighResolutionTicks(); }
+
+    /** Audio thread: accounts for one block of numSamples. */
+    void record(int numSamples, juce::int64 blockStart, juce::int64 bandsEnd, juce::int64 blockEnd) noexcept
+    {
+        if (resetRequested.load(std::memory_order_relaxed))
+            clear();
+
+        const auto busyTicks = blockEnd - blockStart;
+        const auto load = static_cast<double>(busyTicks) / (static_cast<double>(numSamples) * ticksPerSample);
+        const auto bin = juce::jlimit(0, DspLoadStatistics::numHistogramBins - 1,
+                                      static_cast<int>(load * (DspLoadStatistics::numHistogramBins - 1)));
+
+        increment(histogram[static_cast<size_t>(bin)]);
+        increment(numBlocks);
+
+        if (load >= 1.0)
+            increment(missedDeadlines);
+
+        add(numSamplesProcessed, static_cast<juce::uint64>(numSamples));
+        add(busyTicksTotal, static_cast<juce::uint64>(busyTicks));
+        add(bandTicksTotal, static_cast<juce::uint64>(bandsEnd - blockStart));
+        add(analyzerTicksTotal, static_cast<juce::uint64>(blockEnd - bandsEnd));
+
+        if (busyTicks > worstBlockTicks.load(std::memory_order_relaxed))
+            worstBlockTicks.store(busyTicks, std::memory_order_relaxed);
+
+        if (load > worstLoad.load(std::memory_order_relaxed))
+            worstLoad.store(load, std::memory_order_relaxed);
+    }
+
+private:
+    using Counter = std::atomic<juce::uint64>;
+
+    static void increment(Counter& counter) noexcept { add(counter, 1); }
+
+    static void add(Counter& counter, juce::uint64 amount) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void clear() noexcept;
+
+    const double ticksPerSecond;
+    std::atomic<double> sampleRate { 44100.0 };
+    double ticksPerSample = 0.0;
+
+    std::array<Counter, DspLoadStatistics::numHistogramBins> histogram {};
+    Counter numBlocks { 0 }, missedDeadlines { 0 }, numSamplesProcessed { 0 };
+    Counter busyTicksTotal { 0 }, bandTicksTotal { 0 }, analyzerTicksTotal { 0 };
+    std::atomic<juce::int64> worstBlockTicks { 0 };
+    std::atomic<double> worstLoad { 0.0 };
+    std::atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE(DspLoadMonitor)
+};
@@ -0,0 +1,348 @@
+#include "Dynamics.h"
+#include <cmath>
+
+namespace
+{
+    constexpr float silenceDb = -120.0f;
+
+    int getKeySource(ChannelTarget target) noexcept
+    {
+        switch (target)
+        {
+            case ChannelTarget::Left:   return 0;
+            case ChannelTarget::Right:  return 1;
+            case ChannelTarget::Side:   return 3;
+            case ChannelTarget::Mid:
+            case ChannelTarget::Stereo:
+            default:                    return 2;
+        }
+    }
+
+    /** The part of the spectrum a band's gain acts on. */
+    void designDetector(const BiquadDesign::Parameters& parameters, double sampleRate,
+                        BiquadDesign::Coefficients& result) noexcept
+    {
+        if (parameters.type == FilterType::Peak)
+        {
+            BiquadDesign::designBandPass(parameters.frequency, parameters.q, sampleRate, result);
+            return;
+        }
+
+        BiquadDesign::Parameters edge;
+        edge.type = parameters.type == FilterType::LowShelf ? FilterType::LowPass : FilterType::HighPass;
+        edge.frequency = parameters.frequency;
+        edge.q = juce::MathConstants<float>::sqrt2 * 0.5f;
+        BiquadDesign::design(edge, sampleRate, result);
+    }
+
+    /** True if the two settings need different detector filters; the gain doesn't matter. */
+    bool detectorDiffers(const BiquadDesign::Parameters& a, const BiquadDesign::Parameters& b) noexcept
+    {
+        return a.type != b.type || a.frequency != b.frequency || a.q != b.q;
+    }
+
+    float getSmoothingCoefficient(float milliseconds, double sampleRate) noexcept
+    {
+        // One-pole coefficient per control period for a time constant in ms
+        const auto periodSeconds = DynamicsDetector::controlInterval / sampleRate;
+        const auto seconds = juce::jmax(1.0e-4, static_cast<double>(milliseconds) * 0.001);
+        return static_cast<float>(1.0 - std::exp(-periodSeconds / seconds));
+    }
+}
+
+void DynamicsDetector::prepare(double newSampleRate, int maxBlockSize)
+{
+    sampleRate = newSampleRate;
+    maxPeriods = (juce::jmax(1, maxBlockSize) + controlInterval - 1) / controlInterval;
+
+    for (auto& key : keys)
+        key.assign(static_cast<size_t>(maxPeriods * controlInterval), 0.0f);
+
+    gainChanges.assign(static_cast<size_t>(maxPeriods * stride), 0.0f);
+    numBands = 0;
+    numPeriods = 0;
+    reset();
+}
+
+void DynamicsDetector::reset() noexcept
+{
+    const auto zero = Lanes::expand(0.0f);
+    s1.fill(zero);
+    s2.fill(zero);
+
+    for (int i = 0; i < numBands; ++i)
+        bands[static_cast<size_t>(i)].envelopeDb = silenceDb;
+
+    std::fill(gainChanges.begin(), gainChanges.end(), 0.0f);
+}
+
+void DynamicsDetector::setChain(const BandChain& chain) noexcept
+{
+    alignas(64) float coefficients[5][maxLaneGroups * numLanes] = {};
+    alignas(64) float oldState[2][maxLaneGroups * numLanes];
+    alignas(64) float state[2][maxLaneGroups * numLanes] = {};
+    int newNumBands = 0;
+
+    for (int group = 0; group < maxLaneGroups; ++group)
+    {
+        s1[static_cast<size_t>(group)].copyToRawArray(oldState[0] + group * numLanes);
+        s2[static_cast<size_t>(group)].copyToRawArray(oldState[1] + group * numLanes);
+    }
+
+    for (size_t index = 0; index < chain.bands.size() && newNumBands < BandChain::maxBands; ++index)
+    {
+        const auto& source = chain.bands[index];
+
+        if (!source.isDynamic())
+            continue;
+
+        auto& band = scratchBands[static_cast<size_t>(newNumBands)];
+        const auto& dynamics = source.dynamics;
+
+        band.id = source.id;
+        band.chainIndex = static_cast<int>(index);
+        band.keySource = getKeySource(source.target) + (dynamics.useSidechain ? sidechainOffset : 0);
+        band.threshold = dynamics.threshold;
+        band.slope = 1.0f - 1.0f / juce::jlimit(0.1f, 100.0f, dynamics.ratio);
+        band.attackCoefficient = getSmoothingCoefficient(dynamics.attack, sampleRate);
+        band.releaseCoefficient = getSmoothingCoefficient(dynamics.release, sampleRate);
+        band.envelopeDb = silenceDb;
+        band.parameters = source.parameters;
+
+        // Carry over the envelope and key filter of a band that was already
+        // running, so editing the chain doesn't restart its detection
+        for (int old = 0; old < numBands; ++old)
+        {
+            if (bands[static_cast<size_t>(old)].id == band.id)
+            {
+                band.envelopeDb = bands[static_cast<size_t>(old)].envelopeDb;
+                state[0][newNumBands] = oldState[0][old];
+                state[1][newNumBands] = oldState[1][old];
+                break;
+            }
+        }
+
+        BiquadDesign::Coefficients c;
+        designDetector(source.parameters, sampleRate, c);
+
+        for (int k = 0; k < 5; ++k)
+            coefficients[k][newNumBands] = c[static_cast<size_t>(k)];
+
+        ++newNumBands;
+    }
+
+    std::swap(bands, scratchBands);
+    numBands = newNumBands;
+
+    for (int group = 0; group < maxLaneGroups; ++group)
+    {
+        b0[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[0] + group * numLanes);
+        b1[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[1] + group * numLanes);
+        b2[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[2] + group * numLanes);
+        a1[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[3] + group * numLanes);
+        a2[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[4] + group * numLanes);
+        s1[static_cast<size_t>(group)] = Lanes::fromRawArray(state[0] + group * numLanes);
+        s2[static_cast<size_t>(group)] = Lanes::fromRawArray(state[1] + group * numLanes);
+    }
+}
+
+void DynamicsDetector::updateParameters(const BandChain& chain) noexcept
+{
+    const auto numGroups = (numBands + numLanes - 1) / numLanes;
+    alignas(64) float coefficients[5][maxLaneGroups * numLanes];
+    std::array<bool, maxLaneGroups> changedGroups {};
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        b0[static_cast<size_t>(group)].copyToRawArray(coefficients[0] + group * numLanes);
+        b1[static_cast<size_t>(group)].copyToRawArray(coefficients[1] + group * numLanes);
+        b2[static_cast<size_t>(group)].copyToRawArray(coefficients[2] + group * numLanes);
+        a1[static_cast<size_t>(group)].copyToRawArray(coefficients[3] + group * numLanes);
+        a2[static_cast<size_t>(group)].copyToRawArray(coefficients[4] + group * numLanes);
+    }
+
+    // Redesign the bands that moved, then reload only their lane groups; the
+    // filter state is left alone, so detection carries on through the move
+    for (int index = 0; index < numBands; ++index)
+    {
+        auto& band = bands[static_cast<size_t>(index)];
+
+        if (band.chainIndex >= static_cast<int>(chain.bands.size()))
+            continue;
+
+        const auto& source = chain.bands[static_cast<size_t>(band.chainIndex)];
+
+        if (source.id != band.id || !detectorDiffers(source.parameters, band.parameters))
+            continue;
+
+        band.parameters = source.parameters;
+
+        BiquadDesign::Coefficients c;
+        designDetector(band.parameters, sampleRate, c);
+
+        for (int k = 0; k < 5; ++k)
+            coefficients[k][index] = c[static_cast<size_t>(k)];
+
+        changedGroups[static_cast<size_t>(index / numLanes)] = true;
+    }
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        if (!changedGroups[static_cast<size_t>(group)])
+            continue;
+
+        b0[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[0] + group * numLanes);
+        b1[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[1] + group * numLanes);
+        b2[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[2] + group * numLanes);
+        a1[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[3] + group * numLanes);
+        a2[static_cast<size_t>(group)] = Lanes::fromRawArray(coefficients[4] + group * numLanes);
+    }
+}
+
+template <typename SampleType>
+void DynamicsDetector::buildKeys(const SampleType* const* channels, int numChannels, int firstSource,
+                                 int numSamples, const std::array<bool, numKeySources>& needed) noexcept
+{
+    auto* left = keys[static_cast<size_t>(firstSource + inputLeft)].data();
+    auto* right = keys[static_cast<size_t>(firstSource + inputRight)].data();
+    auto* mid = keys[static_cast<size_t>(firstSource + inputMid)].data();
+    auto* side = keys[static_cast<size_t>(firstSource + inputSide)].data();
+
+    if (numChannels == 0)
+    {
+        for (auto* key : { left, right, mid, side })
+            juce::FloatVectorOperations::clear(key, numSamples);
+        return;
+    }
+
+    // A mono key is both sides and all mid
+    const auto* leftInput = channels[0];
+    const auto* rightInput = channels[juce::jmin(1, numChannels - 1)];
+
+    // Straight loops over the block, which vectorize for either sample type
+    if (needed[static_cast<size_t>(firstSource + inputLeft)])
+        for (int i = 0; i < numSamples; ++i)
+            left[i] = static_cast<float>(leftInput[i]);
+
+    if (needed[static_cast<size_t>(firstSource + inputRight)])
+        for (int i = 0; i < numSamples; ++i)
+            right[i] = static_cast<float>(rightInput[i]);
+
+    if (needed[static_cast<size_t>(firstSource + inputMid)])
+        for (int i = 0; i < numSamples; ++i)
+            mid[i] = static_cast<float>((leftInput[i] + rightInput[i]) * SampleType(0.5));
+
+    if (needed[static_cast<size_t>(firstSource + inputSide)])
+        for (int i = 0; i < numSamples; ++i)
+            side[i] = static_cast<float>((leftInput[i] - rightInput[i]) * SampleType(0.5));
+}
+
+template <typename SampleType>
+void DynamicsDetector::process(const SampleType* const* input, int numInputChannels,
+                               const SampleType* const* sidechain, int numSidechainChannels,
+                               int numSamples) noexcept
+{
+    numPeriods = juce::jmin(maxPeriods, (numSamples + controlInterval - 1) / controlInterval);
+    numSamples = juce::jmin(numSamples, maxPeriods * controlInterval);
+
+    if (numBands == 0 || numSamples <= 0)
+        return;
+
+    // Without a sidechain, bands keyed from it listen to the input
+    const auto sidechainShift = numSidechainChannels > 0 ? 0 : sidechainOffset;
+    std::array<bool, numKeySources> needed {};
+    std::array<int, BandChain::maxBands> sources {};
+
+    for (int i = 0; i < numBands; ++i)
+    {
+        auto source = bands[static_cast<size_t>(i)].keySource;
+
+        if (source >= sidechainOffset)
+            source -= sidechainShift;
+
+        sources[static_cast<size_t>(i)] = source;
+        needed[static_cast<size_t>(source)] = true;
+    }
+
+    buildKeys(input, numInputChannels, 0, numSamples, needed);
+
+    if (numSidechainChannels > 0)
+        buildKeys(sidechain, numSidechainChannels, sidechainOffset, numSamples, needed);
+
+    const auto numGroups = (numBands + numLanes - 1) / numLanes;
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        const auto g = static_cast<size_t>(group);
+        const auto c0 = b0[g], c1 = b1[g], c2 = b2[g], d1 = a1[g], d2 = a2[g];
+        auto z1 = s1[g];
+        auto z2 = s2[g];
+
+        // Lanes past the last band repeat its key; their output is never read
+        const float* laneKeys[numLanes];
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            const auto band = juce::jmin(group * numLanes + lane, numBands - 1);
+            laneKeys[lane] = keys[static_cast<size_t>(sources[static_cast<size_t>(band)])].data();
+        }
+
+        for (int period = 0; period < numPeriods; ++period)
+        {
+            const auto start = period * controlInterval;
+            const auto length = juce::jmin(controlInterval, numSamples - start);
+            auto sumOfSquares = Lanes::expand(0.0f);
+            alignas(64) float frame[numLanes];
+
+            for (int i = start; i < start + length; ++i)
+            {
+                for (int lane = 0; lane < numLanes; ++lane)
+                    frame[lane] = laneKeys[lane][i];
+
+                const auto in = Lanes::fromRawArray(frame);
+                const auto out = c0 * in + z1;
+                z1 = c1 * in - d1 * out + z2;
+                z2 = c2 * in - d2 * out;
+                sumOfSquares = sumOfSquares + out * out;
+            }
+
+            // Once per period: level, envelope and gain change for each band
+            alignas(64) float sums[numLanes];
+            sumOfSquares.copyToRawArray(sums);
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const auto index = group * numLanes + lane;
+
+                if (index >= numBands)
+                    break;
+
+                auto& band = bands[static_cast<size_t>(index)];
+                const auto levelDb = juce::jmax(silenceDb, 10.0f * std::log10(sums[lane] / static_cast<float>(length) + 1.0e-12f));
+                const auto coefficient = levelDb > band.envelopeDb ? band.attackCoefficient : band.releaseCoefficient;
+                band.envelopeDb += coefficient * (levelDb - band.envelopeDb);
+
+                const auto excess = juce::jmax(0.0f, band.envelopeDb - band.threshold);
+                gainChanges[static_cast<size_t>(period * stride + band.chainIndex)]
+                    = juce::jlimit(-maxGainChangeDb, maxGainChangeDb, -excess * band.slope);
+            }
+        }
+
+        // Flush denormal-range state, as the cascade does
+        alignas(64) float z[2][numLanes];
+        z1.copyToRawArray(z[0]);
+        z2.copyToRawArray(z[1]);
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            JUCE_SNAP_TO_ZERO(z[0][lane]);
+            JUCE_SNAP_TO_ZERO(z[1][lane]);
+        }
+
+        s1[g] = Lanes::fromRawArray(z[0]);
+        s2[g] = Lanes::fromRawArray(z[1]);
+    }
+}
+
+template void DynamicsDetector::process<float>(const float* const*, int, const float* const*, int, int) noexcept;
+template void DynamicsDetector::process<double>(const double* const*, int, const double* const*, int, int) noexcept;
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <vector>
+#include "BandChain.h"
+#include "BiquadCascade.h"
+
+/** Level detection and gain computation for the dynamic bands of a chain.
+
+    Each dynamic band listens to its own frequency range of a key signal: a
+    band-pass at the band's frequency and Q for peaks, a low-pass for low
+    shelves and a high-pass for high shelves. The key is the part of the
+    input (or the sidechain) the band acts on: the left or right channel,
+    mid or side, with Stereo bands keyed from the mid.
+
+    Detection is block-wise. Up to one SIMD register's worth of bands run
+    their detector filters side by side in the lanes, and the filtered key
+    is only squared and summed per sample. Everything else runs once per
+    control period of BiquadCascade::tileSize samples: the mean square
+    becomes a level in dB, the attack/release envelope follows it, and the
+    ratio turns it into a gain change. The cascade redesigns a dynamic band
+    once per tile from that gain change and ramps its coefficients across
+    the tile, so nothing is designed per sample.
+*/
+class DynamicsDetector
+{
+public:
+    static constexpr int controlInterval = BiquadCascade<float>::tileSize;
+
+    // Gain changes are [period * stride + chain band index]
+    static constexpr int stride = BandChain::maxBands;
+
+    // Furthest a dynamic band moves from its static gain, either way
+    static constexpr float maxGainChangeDb = 24.0f;
+
+    DynamicsDetector() = default;
+
+    /** Allocates for blocks of up to maxBlockSize samples. Not realtime safe. */
+    void prepare(double sampleRate, int maxBlockSize);
+    void reset() noexcept;
+
+    /** Audio thread: takes the dynamic bands of a new chain, keeping the
+        envelopes and key filter state of bands that survive.
+    */
+    void setChain(const BandChain& chain) noexcept;
+
+    /** Audio thread: follows a chain whose bands have only moved, as
+        BiquadCascade::updateParameters does, redesigning the key filters of
+        bands whose frequency, Q or type changed while keeping their state.
+    */
+    void updateParameters(const BandChain& chain) noexcept;
+
+    bool isActive() const noexcept { return numBands > 0; }
+
+    /** Audio thread: measures one block of float or double samples. The
+        sidechain may be empty, in which case bands keyed from it listen to
+        the input instead. Detection itself always runs in float.
+    */
+    template <typename SampleType>
+    void process(const SampleType* const* input, int numInputChannels,
+                 const SampleType* const* sidechain, int numSidechainChannels,
+                 int numSamples) noexcept;
+
+    /** Gain changes in dB for each control period of the last block. */
+    const float* getGainChanges() const noexcept { return gainChanges.data(); }
+    int getNumPeriods() const noexcept { return numPeriods; }
+
+private:
+    using Lanes = LaneVector<float>;
+    static constexpr int numLanes = BiquadCascade<float>::numLanes;
+    static constexpr int maxLaneGroups = (BandChain::maxBands + numLanes - 1) / numLanes;
+
+    // Key signals: input left, right, mid and side, then the same for the sidechain
+    enum KeySource { inputLeft, inputRight, inputMid, inputSide, sidechainOffset = 4, numKeySources = 8 };
+
+    struct Band
+    {
+        juce::uint32 id = 0;
+        int chainIndex = 0;
+        int keySource = inputMid;
+        float threshold = 0.0f;
+        float slope = 0.0f;           // 1 - 1 / ratio
+        float attackCoefficient = 1.0f;
+        float releaseCoefficient = 1.0f;
+        float envelopeDb = -120.0f;
+        BiquadDesign::Parameters parameters {};   // what the key filter was designed from
+    };
+
+    double sampleRate = 44100.0;
+    int maxPeriods = 0;
+    int numPeriods = 0;
+
+    std::array<Band, BandChain::maxBands> bands {}, scratchBands {};
+    int numBands = 0;
+
+    // Detector filters, lane l of group g being band g * numLanes + l
+    std::array<Lanes, maxLaneGroups> b0 {}, b1 {}, b2 {}, a1 {}, a2 {}, s1 {}, s2 {};
+
+    std::array<std::vector<float>, numKeySources> keys;
+    std::vector<float> gainChanges;
+
+    template <typename SampleType>
+    void buildKeys(const SampleType* const* channels, int numChannels, int firstSource,
+                   int numSamples, const std::array<bool, numKeySources>& needed) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE(DynamicsDetector)
+};
@@ -1,35 +1,38 @@
 #include "EQBand.h"
+#include <atomic>
 #include <cmath>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+static std::atomic<juce::uint32> nextBandId { 1 };
+
+static constexpr float responseMinFrequency = 20.0f;
+static constexpr float responseMaxFrequency = 20000.0f;
+
 EQBand::EQBand()
-    : type(FilterType::Peak)
+    : EQBand(44100.0)
+{
+}
+
+EQBand::EQBand(double initialSampleRate)
+    : id(nextBandId++)
+    , type(FilterType::Peak)
     , frequency(1000.0f)
     , gain(0.0f)
     , q(1.0f)
-    , sampleRate(44100.0)
+    , sampleRate(initialSampleRate)
     , position(0.5f, 0.5f)
+    , gridPhi(numResponsePoints)
+    , responseDb(numResponsePoints)
 {
-}
-
-EQBand::~EQBand()
-{
-}
-
-void EQBand::prepare(const juce::dsp::ProcessSpec& spec)
-{
-    sampleRate = spec.sampleRate;
-    filterProcessor.prepare(spec);
+    updateResponseGrid();
     updateFilter();
-    filterProcessor.reset();
 }
 
-void EQBand::process(juce::dsp::ProcessContextReplacing<float>& context)
+EQBand::~EQBand()
 {
-    filterProcessor.process(context);
 }
 
 void EQBand::setFrequency(float newFrequency)
@@ -56,94 +59,75 @@ void EQBand::setType(FilterType newType)
     updateFilter();
 }
 
+void EQBand::restore(const BiquadDesign::Parameters& parameters, ChannelTarget newTarget,
+                     const BandDynamics& newDynamics, const BandTracking& newTracking,
+                     const BiquadDesign::Coefficients& designed)
+{
+    type = parameters.type;
+    frequency = parameters.frequency;
+    gain = parameters.gain;
+    q = parameters.q;
+    channelTarget = newTarget;
+    dynamics = newDynamics;
+    tracking = newTracking;
+    coefficients = designed;
+    responseIsDirty = true;
+}
+
 void EQBand::updateFilter()
 {
-    switch (type)
-    {
-        case FilterType::LowShelf:
-            *filterProcessor.state = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(
-                sampleRate, frequency, q, juce::Decibels::decibelsToGain(gain));
-            break;
-            
-        case FilterType::HighShelf:
-            *filterProcessor.state = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(
-                sampleRate, frequency, q, juce::Decibels::decibelsToGain(gain));
-            break;
-            
-        case FilterType::Peak:
-            *filterProcessor.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-                sampleRate, frequency, q, juce::Decibels::decibelsToGain(gain));
-            break;
-            
-        case FilterType::Notch:
-            *filterProcessor.state = *juce::dsp::IIR::Coefficients<float>::makeNotch(
-                sampleRate, frequency, q);
-            break;
-            
-        case FilterType::LowPass:
-            *filterProcessor.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(
-                sampleRate, frequency, q);
-            break;
-            
-        case FilterType::HighPass:
-            *filterProcessor.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(
-                sampleRate, frequency, q);
-            break;
-    }
+    // Written in place, no heap traffic, so drags and automation stay cheap
+    BiquadDesign::design(getParameters(), sampleRate, coefficients);
+    responseIsDirty = true;
+}
+
+void EQBand::setSampleRate(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    updateResponseGrid();
+    updateFilter();
+}
+
+void EQBand::setSampleRate(double newSampleRate, const BiquadDesign::Coefficients& designed)
+{
+    sampleRate = newSampleRate;
+    updateResponseGrid();
+    coefficients = designed;
+    responseIsDirty = true;
 }
 
 float EQBand::calculateGain(float frequency) const
 {
-    // Frequency ratio (input frequency / filter frequency)
-    const float freqRatio = frequency / this->frequency;
+    const auto halfW = juce::MathConstants<double>::pi * frequency / sampleRate;
+    const auto phi = static_cast<float>(std::sin(halfW) * std::sin(halfW));
     
-    // Calculate response based on filter type
-    switch (type)
+    float decibels;
+    BiquadDesign::getMagnitudeResponseDb(coefficients, &phi, &decibels, 1);
+    return decibels;
+}
+
+float EQBand::getResponseFrequency(int index)
+{
+    const auto t = static_cast<float>(index) / static_cast<float>(numResponsePoints - 1);
+    return responseMinFrequency * std::pow(responseMaxFrequency / responseMinFrequency, t);
+}
+
+const std::vector<float>& EQBand::getResponseDb() const
+{
+    if (responseIsDirty)
     {
-        case FilterType::Peak:
-        {
-            // Peak filter response using a simplified resonant filter equation
-            float response = gain / (1.0f + std::pow((freqRatio - 1.0f/freqRatio) / q, 2));
-            return response;
-        }
-        
-        case FilterType::LowShelf:
-        {
-            // Butterworth lowshelf response
-            float response = gain / (1.0f + std::pow(freqRatio / q, 2));
-            return response;
-        }
-        
-        case FilterType::HighShelf:
-        {
-            // Butterworth highshelf response
-            float response = gain / (1.0f + std::pow(1.0f / (freqRatio * q), 2));
-            return response;
-        }
-        
-        case FilterType::LowPass:
-        {
-            // -12 dB/octave lowpass response
-            float response = -12.0f * std::log2(std::max(freqRatio, 0.001f));
-            return std::min(0.0f, response);
-        }
-        
-        case FilterType::HighPass:
-        {
-            // -12 dB/octave highpass response
-            float response = -12.0f * std::log2(std::max(1.0f/freqRatio, 0.001f));
-            return std::min(0.0f, response);
-        }
-        
-        case FilterType::Notch:
-        {
-            // Notch filter response
-            float bw = 1.0f / q;  // bandwidth
-            float response = -gain * (1.0f / (1.0f + std::pow((freqRatio - 1.0f/freqRatio) / bw, 2)));
-            return response;
-        }
-        
-        default:
-            return 0.0f;
+        BiquadDesign::getMagnitudeResponseDb(coefficients, gridPhi.data(), responseDb.data(), numResponsePoints);
+        responseIsDirty = false;
     }
-} 
\ No newline at end of file
+    
+    return responseDb;
+}
+
+void EQBand::updateResponseGrid()
+{
+    for (int i = 0; i < numResponsePoints; ++i)
+    {
+        const auto halfW = juce::MathConstants<double>::pi * getResponseFrequency(i) / sampleRate;
+        gridPhi[static_cast<size_t>(i)] = static_cast<float>(std::sin(halfW) * std::sin(halfW));
+    }
+}
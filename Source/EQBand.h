@@ -1,54 +1,142 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
-#include <juce_dsp/juce_dsp.h>
 #include <juce_gui_basics/juce_gui_basics.h>
+#include "BiquadDesign.h"
+#include <vector>
 
-enum class FilterType
+/** Which part of the signal a band acts on. Everything but Stereo refers to
+    the first two channels, taken as left and right; those bands leave every
+    other channel alone.
+*/
+enum class ChannelTarget
 {
-    LowShelf,
-    HighShelf,
-    Peak,
-    Notch,
-    LowPass,
-    HighPass
+    Stereo,
+    Left,
+    Right,
+    Mid,
+    Side
+};
+
+/** Turns a band into a dynamic one: its gain moves with the level of the
+    band's own frequency range in a key signal, the input or the sidechain.
+    Above the threshold the level is compressed by ratio, so the band cuts
+    by (level - threshold) * (1 - 1 / ratio) dB on top of its static gain;
+    a ratio below 1 boosts instead. Only peaks and shelves have a gain to
+    move; other types ignore this.
+*/
+struct BandDynamics
+{
+    bool enabled = false;
+    bool useSidechain = false;
+    float threshold = -24.0f;   // dB
+    float ratio = 2.0f;
+    float attack = 10.0f;       // ms
+    float release = 100.0f;     // ms
+};
+
+/** Ties a band to incoming MIDI. With a harmonic set, the band's frequency
+    follows the last held note, at that harmonic of its pitch, so a
+    resonance that moves with what is played gets tamed wherever it goes.
+    Its gain can also be scaled by the note's velocity or by a controller,
+    from nothing at 0 to the full set gain at 127. Until the first note or
+    controller value arrives the band keeps its own settings. Only the
+    minimum-phase path tracks, and not during a snapshot morph; otherwise
+    the set values apply.
+*/
+struct BandTracking
+{
+    enum class GainSource { fixed, velocity, controller };
+
+    static constexpr int maxHarmonic = 16;
+
+    int harmonic = 0;                           // 0 leaves the frequency alone
+    GainSource gainSource = GainSource::fixed;
+    int controller = 1;                         // CC number, for GainSource::controller
+
+    bool isActive() const noexcept { return harmonic > 0 || gainSource != GainSource::fixed; }
 };
 
 class EQBand
 {
 public:
     EQBand();
+    explicit EQBand(double initialSampleRate);
     ~EQBand();
 
-    void prepare(const juce::dsp::ProcessSpec& spec);
-    void process(juce::dsp::ProcessContextReplacing<float>& context);
-    
     void setFrequency(float newFrequency);
     void setGain(float newGain);
     void setQ(float newQ);
     void setType(FilterType newType);
+    void setChannelTarget(ChannelTarget newTarget) { channelTarget = newTarget; }
+    void setDynamics(const BandDynamics& newDynamics) { dynamics = newDynamics; }
+    void setTracking(const BandTracking& newTracking) { tracking = newTracking; }
+    
+    // Replaces every setting at once, with coefficients already designed for
+    // them at this band's sample rate (e.g. a whole session in one batch), so
+    // nothing is redesigned per setter
+    void restore(const BiquadDesign::Parameters& parameters, ChannelTarget newTarget,
+                 const BandDynamics& newDynamics, const BandTracking& newTracking,
+                 const BiquadDesign::Coefficients& designed);
     
     float getFrequency() const { return frequency; }
     float getGain() const { return gain; }
     float getQ() const { return q; }
     FilterType getType() const { return type; }
+    ChannelTarget getChannelTarget() const { return channelTarget; }
+    const BandDynamics& getDynamics() const { return dynamics; }
+    const BandTracking& getTracking() const { return tracking; }
+    
+    // Stable identity used to carry filter state across band chain snapshots
+    juce::uint32 getId() const { return id; }
+    
+    // The host parameter slot mirroring this band, -1 until the processor assigns one
+    int getSlot() const { return slot; }
+    void setSlot(int newSlot) { slot = newSlot; }
+    
+    BiquadDesign::Parameters getParameters() const { return { type, frequency, gain, q }; }
+    
+    // Normalised biquad coefficients { b0, b1, b2, a1, a2 } for the current settings
+    const BiquadDesign::Coefficients& getCoefficients() const { return coefficients; }
     
     juce::Point<float> getPosition() const { return position; }
     void setPosition(juce::Point<float> newPosition) { position = newPosition; }
     
-    void setSampleRate(double newSampleRate) { sampleRate = newSampleRate; updateFilter(); }
+    void setSampleRate(double newSampleRate);
+    
+    // As above, with coefficients already designed at the new rate (every
+    // band of a session in one batch), so nothing is redesigned here
+    void setSampleRate(double newSampleRate, const BiquadDesign::Coefficients& designed);
 
+    // Exact gain in dB of the band's biquad at the given frequency
     float calculateGain(float frequency) const;
+    
+    // Magnitude response in dB on the display grid (log-spaced, 20 Hz - 20 kHz),
+    // evaluated from the actual coefficients and only recomputed after a change
+    static constexpr int numResponsePoints = 200;
+    static float getResponseFrequency(int index);
+    const std::vector<float>& getResponseDb() const;
 
 private:
+    juce::uint32 id;
     FilterType type;
     float frequency;
     float gain;
     float q;
+    ChannelTarget channelTarget = ChannelTarget::Stereo;
+    BandDynamics dynamics;
+    BandTracking tracking;
+    int slot = -1;
     double sampleRate;
     juce::Point<float> position;
     
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> filterProcessor;
+    BiquadDesign::Coefficients coefficients { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    
+    // sin^2(w/2) of the display grid at this band's sample rate
+    std::vector<float> gridPhi;
+    mutable std::vector<float> responseDb;
+    mutable bool responseIsDirty = true;
     
     void updateFilter();
+    void updateResponseGrid();
 }; 
\ No newline at end of file
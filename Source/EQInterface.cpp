@@ -3,46 +3,126 @@
 
 EQInterface::EQInterface()
 {
-    addMouseListener(this, true);
     // Initialize FFT analyzer with 2 channels and order 11 (2048 samples)
     fftAnalyzer = std::make_unique<SondyFFT::MultiChannelFFTSpectrumAnalyzer>(2, 11);
+    fftAnalyzer->setHopSize(fftAnalyzer->getFFTSize() / 4);  // 75% overlap
     spectrumComponent = std::make_unique<SondyFFT::MultiChannelSpectrumComponent>(*fftAnalyzer);
     spectrumComponent->setOverlayMode(true); // Overlay the channels
-    addAndMakeVisible(spectrumComponent.get());
     
-    // Start the timer for updates - reduced from 30Hz to 15Hz for smoother updates
-    startTimerHz(15);
+    // The spectrum isn't a child component: paint() draws it once, between
+    // the cached layers, so it isn't painted twice
+    
+    // The grid layer covers every pixel
+    setOpaque(true);
 }
 
 EQInterface::~EQInterface()
 {
-    stopTimer();
+    if (audioProcessor)
+        audioProcessor->setAnalyzerEnabled(false);
+    
+    analysisThread = nullptr;
     spectrumComponent = nullptr;
     fftAnalyzer = nullptr;
 }
 
-void EQInterface::timerCallback()
+void EQInterface::setProcessor(SondyEQAudioProcessor* processor)
+{
+    if (audioProcessor)
+        audioProcessor->setAnalyzerEnabled(false);
+    
+    analysisThread = nullptr;
+    audioProcessor = processor;
+    
+    if (audioProcessor)
+    {
+        bandListSerial = audioProcessor->getBandListSerial();
+        bandSettingsSerial = audioProcessor->getBandSettingsSerial();
+        
+        // FFT work runs on its own thread, fed by the processor's ring buffer
+        analysisThread = std::make_unique<SondyFFT::AnalysisThread>(
+            audioProcessor->getAnalyzerFeed(), *fftAnalyzer,
+            [p = audioProcessor] { return p->getSampleRate() > 0.0 ? p->getSampleRate() : 44100.0; });
+        analysisThread->startThread();
+        audioProcessor->setAnalyzerEnabled(true);
+    }
+}
+
+void EQInterface::onVBlank()
+{
+    syncBandList();
+    
+    // A new analyzer frame only touches the spectrum area; when audio stops the
+    // analyzer stops publishing, and this callback goes quiet
+    if (fftAnalyzer && fftAnalyzer->fetchLatestFrame())
+        invalidate(spectrumComponent->getSpectrumArea());
+    
+    if (showDspLoad && juce::Time::getMillisecondCounter() - lastLoadOverlayUpdate >= loadOverlayIntervalMs)
+        updateLoadOverlay();
+    
+    if (!pendingRepaint.isEmpty())
+    {
+        repaint(pendingRepaint);
+        pendingRepaint = {};
+    }
+}
+
+void EQInterface::syncBandList()
 {
-    // Update the frequency response and display
+    if (!audioProcessor)
+        return;
+    
+    const auto listSerial = audioProcessor->getBandListSerial();
+    const auto settingsSerial = audioProcessor->getBandSettingsSerial();
+    
+    if (listSerial == bandListSerial && settingsSerial == bandSettingsSerial)
+        return;
+    
+    // A new band list invalidates the selection; automation only moves bands
+    if (listSerial != bandListSerial)
+        selectedBand = nullptr;
+    
+    bandListSerial = listSerial;
+    bandSettingsSerial = settingsSerial;
     updateFrequencyResponse();
-    repaint();
+}
+
+void EQInterface::invalidate(juce::Rectangle<int> area)
+{
+    pendingRepaint = pendingRepaint.getUnion(area.getIntersection(getLocalBounds()));
 }
 
 void EQInterface::updateBands()
 {
     if (audioProcessor)
-    {
         updateFrequencyResponse();
-        repaint();
-    }
 }
 
 void EQInterface::paint(juce::Graphics& g)
 {
-    // Fill background
-    g.fillAll(juce::Colours::black);
+    // The layers are only re-rendered when their contents change; a regular
+    // frame is just the spectrum plus compositing
+    const float scale = getLayerScale();
+    const auto layerBounds = getLayerPixelBounds(scale);
+    
+    if (gridLayer.getBounds() != layerBounds)
+        renderGridLayer(scale);
+    
+    if (curveLayer.getBounds() != layerBounds)
+    {
+        curveLayer = {};
+        curveLayerDirtyArea = getLocalBounds();
+    }
+    
+    if (!curveLayerDirtyArea.isEmpty())
+        renderCurveLayer(scale);
+
+    const auto bounds = getLocalBounds().toFloat();
 
-    // Draw FFT spectrum first (background)
+    // Background, grid and axis labels
+    g.drawImage(gridLayer, bounds);
+
+    // FFT spectrum, the only thing drawn from scratch every frame
     if (spectrumComponent)
     {
         // Create a temporary graphics context with reduced opacity
@@ -51,96 +131,251 @@ void EQInterface::paint(juce::Graphics& g)
         spectrumComponent->paint(g);
     }
 
-    // Draw grid lines
-    drawGridLines(g);
+    // Response curve and band nodes
+    g.drawImage(curveLayer, bounds);
+    
+    if (showDspLoad)
+        drawLoadOverlay(g);
+}
+
+juce::Rectangle<int> EQInterface::getLoadOverlayArea() const
+{
+    return { getWidth() - 190, 8, 182, 76 };
+}
 
-    // Update and draw frequency response
-    if (audioProcessor && !audioProcessor->getBands().empty())
+void EQInterface::updateLoadOverlay()
+{
+    lastLoadOverlayUpdate = juce::Time::getMillisecondCounter();
+    
+    if (!audioProcessor)
+        return;
+    
+    previousLoadStatistics = loadStatistics;
+    loadStatistics = audioProcessor->getDspLoadStatistics();
+    recentLoad = loadStatistics.getLoadSince(previousLoadStatistics);
+    invalidate(getLoadOverlayArea());
+}
+
+void EQInterface::drawLoadOverlay(juce::Graphics& g)
+{
+    const auto area = getLoadOverlayArea();
+    g.setColour(juce::Colours::black.withAlpha(0.7f));
+    g.fillRoundedRectangle(area.toFloat(), 4.0f);
+    
+    const auto percent = [](double fraction) { return juce::String(fraction * 100.0, 1) + "%"; };
+    auto text = area.reduced(6, 4);
+    
+    g.setColour(juce::Colours::white.withAlpha(0.85f));
+    g.setFont(11.0f);
+    g.drawText("DSP " + percent(recentLoad) + "  avg " + percent(loadStatistics.getAverageLoad())
+                   + "  worst " + percent(loadStatistics.worstLoad),
+               text.removeFromTop(14), juce::Justification::centredLeft);
+    g.drawText("Bands " + percent(loadStatistics.getBandShare())
+                   + "  Analyzer " + percent(loadStatistics.getAnalyzerShare()),
+               text.removeFromTop(14), juce::Justification::centredLeft);
+    
+    g.setColour(loadStatistics.missedDeadlines > 0 ? juce::Colours::orangered : juce::Colours::white.withAlpha(0.85f));
+    g.drawText("Missed deadlines " + juce::String(static_cast<juce::int64>(loadStatistics.missedDeadlines)),
+               text.removeFromTop(14), juce::Justification::centredLeft);
+    
+    // Load histogram, 0 to 100% left to right plus the overrun bin; bar
+    // heights are relative to the fullest bin
+    const auto bars = text.reduced(0, 2).toFloat();
+    const auto tallest = *std::max_element(loadStatistics.histogram.begin(), loadStatistics.histogram.end());
+    
+    if (tallest == 0)
+        return;
+    
+    const auto barWidth = bars.getWidth() / DspLoadStatistics::numHistogramBins;
+    
+    for (int i = 0; i < DspLoadStatistics::numHistogramBins; ++i)
     {
-        updateFrequencyResponse();
+        const auto count = loadStatistics.histogram[static_cast<size_t>(i)];
         
-        // Draw frequency response curve with solid white first (for visibility)
-        g.setColour(juce::Colours::white.withAlpha(0.8f));
-        g.strokePath(frequencyResponsePath, juce::PathStrokeType(2.0f));
+        if (count == 0)
+            continue;
         
-        // Then draw with gradient
-        juce::ColourGradient gradient;
-        const auto& processorBands = audioProcessor->getBands();
+        const auto height = juce::jmax(1.0f, bars.getHeight() * static_cast<float>(count) / static_cast<float>(tallest));
+        const auto isOverrun = i == DspLoadStatistics::numHistogramBins - 1;
         
-        // Add gradient stops for each band
-        for (size_t i = 0; i < processorBands.size(); ++i)
+        g.setColour(isOverrun ? juce::Colours::orangered : juce::Colours::lightgreen.withAlpha(0.8f));
+        g.fillRect(bars.getX() + barWidth * i, bars.getBottom() - height, barWidth - 1.0f, height);
+    }
+}
+
+float EQInterface::getLayerScale() const
+{
+    // Render layers at the display's pixel density so they stay sharp on HiDPI screens
+    return juce::Component::getApproximateScaleFactorForComponent(this);
+}
+
+juce::Rectangle<int> EQInterface::getLayerPixelBounds(float scale) const
+{
+    return { juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+             juce::jmax(1, juce::roundToInt(getHeight() * scale)) };
+}
+
+void EQInterface::renderGridLayer(float scale)
+{
+    const auto pixelBounds = getLayerPixelBounds(scale);
+    gridLayer = juce::Image(juce::Image::ARGB, pixelBounds.getWidth(), pixelBounds.getHeight(), true);
+    
+    juce::Graphics g(gridLayer);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    
+    g.fillAll(juce::Colours::black);
+    drawGridLines(g);
+    drawAxisLabels(g);
+}
+
+void EQInterface::renderCurveLayer(float scale)
+{
+    const auto area = curveLayerDirtyArea;
+    curveLayerDirtyArea = {};
+    
+    if (curveLayer.isNull())
+    {
+        const auto pixelBounds = getLayerPixelBounds(scale);
+        curveLayer = juce::Image(juce::Image::ARGB, pixelBounds.getWidth(), pixelBounds.getHeight(), true);
+    }
+    else
+    {
+        // Only the invalidated part is cleared and redrawn
+        curveLayer.clear((area.toFloat() * scale).getSmallestIntegerContainer());
+    }
+    
+    if (!audioProcessor || audioProcessor->getBands().empty())
+        return;
+    
+    juce::Graphics g(curveLayer);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    g.reduceClipRegion(area);
+    
+    // Draw frequency response curve with solid white first (for visibility)
+    g.setColour(juce::Colours::white.withAlpha(0.8f));
+    g.strokePath(frequencyResponsePath, juce::PathStrokeType(2.0f));
+    
+    // Then draw with gradient
+    juce::ColourGradient gradient;
+    const auto& processorBands = audioProcessor->getBands();
+    
+    // Add gradient stops for each band
+    for (size_t i = 0; i < processorBands.size(); ++i)
+    {
+        const auto& band = processorBands[i];
+        juce::Colour bandColor;
+        switch (band->getType())
         {
-            const auto& band = processorBands[i];
-            juce::Colour bandColor;
-            switch (band->getType())
-            {
-                case FilterType::LowShelf:   bandColor = juce::Colours::blue; break;
-                case FilterType::HighShelf:  bandColor = juce::Colours::red; break;
-                case FilterType::Peak:       bandColor = juce::Colours::green; break;
-                case FilterType::Notch:      bandColor = juce::Colours::yellow; break;
-                case FilterType::LowPass:    bandColor = juce::Colours::cyan; break;
-                case FilterType::HighPass:   bandColor = juce::Colours::magenta; break;
-            }
-            
-            float brightness = juce::jmap(band->getGain(), minGain, maxGain, 0.3f, 1.0f);
-            bandColor = bandColor.withBrightness(brightness);
-            gradient.addColour(static_cast<float>(i) / (processorBands.size() - 1), bandColor);
+            case FilterType::LowShelf:   bandColor = juce::Colours::blue; break;
+            case FilterType::HighShelf:  bandColor = juce::Colours::red; break;
+            case FilterType::Peak:       bandColor = juce::Colours::green; break;
+            case FilterType::Notch:      bandColor = juce::Colours::yellow; break;
+            case FilterType::LowPass:    bandColor = juce::Colours::cyan; break;
+            case FilterType::HighPass:   bandColor = juce::Colours::magenta; break;
         }
         
-        if (processorBands.size() == 1)
+        float brightness = juce::jmap(band->getGain(), minGain, maxGain, 0.3f, 1.0f);
+        bandColor = bandColor.withBrightness(brightness);
+        gradient.addColour(static_cast<float>(i) / (processorBands.size() - 1), bandColor);
+    }
+    
+    if (processorBands.size() == 1)
+    {
+        gradient.addColour(1.0f, processorBands[0]->getType() == FilterType::Peak ? 
+                         juce::Colours::green : juce::Colours::blue);
+    }
+    
+    gradient.point1 = { 0.0f, 0.0f };
+    gradient.point2 = { static_cast<float>(getWidth()), 0.0f };
+    gradient.isRadial = false;
+    
+    g.setGradientFill(gradient);
+    g.strokePath(frequencyResponsePath, juce::PathStrokeType(2.0f));
+    
+    // Draw band nodes
+    for (const auto& band : processorBands)
+    {
+        float x = frequencyToX(band->getFrequency());
+        float y = gainToY(band->getGain());
+        
+        juce::Colour bandColor;
+        switch (band->getType())
         {
-            gradient.addColour(1.0f, processorBands[0]->getType() == FilterType::Peak ? 
-                             juce::Colours::green : juce::Colours::blue);
+            case FilterType::LowShelf:   bandColor = juce::Colours::blue; break;
+            case FilterType::HighShelf:  bandColor = juce::Colours::red; break;
+            case FilterType::Peak:       bandColor = juce::Colours::green; break;
+            case FilterType::Notch:      bandColor = juce::Colours::yellow; break;
+            case FilterType::LowPass:    bandColor = juce::Colours::cyan; break;
+            case FilterType::HighPass:   bandColor = juce::Colours::magenta; break;
         }
         
-        gradient.point1 = { 0.0f, 0.0f };
-        gradient.point2 = { static_cast<float>(getWidth()), 0.0f };
-        gradient.isRadial = false;
+        float brightness = juce::jmap(band->getGain(), minGain, maxGain, 0.3f, 1.0f);
+        bandColor = bandColor.withBrightness(brightness);
+        
+        // Draw the band node
+        g.setColour(band.get() == selectedBand ? bandColor.brighter(0.5f) : bandColor);
+        g.fillEllipse(x - 6, y - 6, 12, 12);
         
-        g.setGradientFill(gradient);
-        g.strokePath(frequencyResponsePath, juce::PathStrokeType(2.0f));
+        // Draw band outline
+        g.setColour(juce::Colours::black);
+        g.drawEllipse(x - 6, y - 6, 12, 12, 1.0f);
         
-        // Draw band nodes
-        for (const auto& band : processorBands)
+        // Dynamic bands get a ring in their own colour
+        if (band->getDynamics().enabled)
         {
-            float x = frequencyToX(band->getFrequency());
-            float y = gainToY(band->getGain());
-            
-            juce::Colour bandColor;
-            switch (band->getType())
-            {
-                case FilterType::LowShelf:   bandColor = juce::Colours::blue; break;
-                case FilterType::HighShelf:  bandColor = juce::Colours::red; break;
-                case FilterType::Peak:       bandColor = juce::Colours::green; break;
-                case FilterType::Notch:      bandColor = juce::Colours::yellow; break;
-                case FilterType::LowPass:    bandColor = juce::Colours::cyan; break;
-                case FilterType::HighPass:   bandColor = juce::Colours::magenta; break;
-            }
-            
-            float brightness = juce::jmap(band->getGain(), minGain, maxGain, 0.3f, 1.0f);
-            bandColor = bandColor.withBrightness(brightness);
-            
-            // Draw the band node
-            g.setColour(band.get() == selectedBand ? bandColor.brighter(0.5f) : bandColor);
-            g.fillEllipse(x - 6, y - 6, 12, 12);
-            
-            // Draw band outline
+            g.setColour(bandColor);
+            g.drawEllipse(x - 9, y - 9, 18, 18, 1.0f);
             g.setColour(juce::Colours::black);
-            g.drawEllipse(x - 6, y - 6, 12, 12, 1.0f);
-            
-            // Draw frequency and gain labels
-            g.setColour(juce::Colours::white);
-            g.setFont(12.0f);
-            
-            juce::String freqText = juce::String(band->getFrequency(), 0) + " Hz";
-            g.drawText(freqText, x - 30, y - 25, 60, 20, juce::Justification::centred);
-            
-            juce::String gainText = juce::String(band->getGain(), 1) + " dB";
-            g.drawText(gainText, x - 30, y + 5, 60, 20, juce::Justification::centred);
         }
+        
+        // Bands acting on part of the stereo pair are marked with its initial
+        if (const auto* initial = getChannelTargetInitial(band->getChannelTarget()))
+        {
+            g.setFont(9.0f);
+            g.drawText(initial, juce::Rectangle<float>(x - 6, y - 6, 12, 12), juce::Justification::centred);
+        }
+        
+        // Draw frequency and gain labels
+        g.setColour(juce::Colours::white);
+        g.setFont(12.0f);
+        
+        juce::String freqText = juce::String(band->getFrequency(), 0) + " Hz";
+        g.drawText(freqText, x - 30, y - 25, 60, 20, juce::Justification::centred);
+        
+        juce::String gainText = juce::String(band->getGain(), 1) + " dB";
+        g.drawText(gainText, x - 30, y + 5, 60, 20, juce::Justification::centred);
     }
 }
 
+const char* EQInterface::getChannelTargetInitial(ChannelTarget target)
+{
+    switch (target)
+    {
+        case ChannelTarget::Left:   return "L";
+        case ChannelTarget::Right:  return "R";
+        case ChannelTarget::Mid:    return "M";
+        case ChannelTarget::Side:   return "S";
+        case ChannelTarget::Stereo: break;
+    }
+    
+    return nullptr;
+}
+
+void EQInterface::invalidateCurveLayer(juce::Rectangle<int> area)
+{
+    area = area.getIntersection(getLocalBounds());
+    curveLayerDirtyArea = curveLayerDirtyArea.getUnion(area);
+    invalidate(area);
+}
+
+juce::Rectangle<int> EQInterface::getNodeArea(float frequency, float gain) const
+{
+    // The node plus its frequency and gain labels, with room for antialiasing
+    const float x = frequencyToX(frequency);
+    const float y = gainToY(gain);
+    return juce::Rectangle<float>(x - 32.0f, y - 27.0f, 64.0f, 54.0f).getSmallestIntegerContainer();
+}
+
 void EQInterface::resized()
 {
     // Make the spectrum component fill the entire interface
@@ -148,11 +383,17 @@ void EQInterface::resized()
     {
         spectrumComponent->setBounds(getLocalBounds());
     }
+    
+    // The layers are rebuilt at the new size on the next paint; forgetting
+    // what was drawn makes the next update invalidate the whole curve
+    drawnNodes.clear();
     updateFrequencyResponse();
 }
 
 void EQInterface::mouseDown(const juce::MouseEvent& e)
 {
+    syncBandList();
+    
     if (audioProcessor)
     {
         // Handle right-click
@@ -170,6 +411,9 @@ void EQInterface::mouseDown(const juce::MouseEvent& e)
                     return;
                 }
             }
+            
+            // Right-click on empty space opens the global settings
+            showSettingsMenu(e.getScreenPosition());
             return;
         }
         
@@ -183,19 +427,29 @@ void EQInterface::mouseDown(const juce::MouseEvent& e)
             if (e.position.getDistanceFrom(juce::Point<float>(x, y)) < 8.0f)
             {
                 selectedBand = band.get();
-                repaint();
+                
+                // The drag that may follow is one gesture for the host
+                gestureSlot = band->getSlot();
+                audioProcessor->beginParameterGesture(gestureSlot);
+                
+                updateFrequencyResponse();
                 return;
             }
         }
         
         // If we didn't click on a band, deselect the current band
-        selectedBand = nullptr;
-        repaint();
+        if (selectedBand != nullptr)
+        {
+            selectedBand = nullptr;
+            updateFrequencyResponse();
+        }
     }
 }
 
 void EQInterface::mouseDoubleClick(const juce::MouseEvent& e)
 {
+    syncBandList();
+    
     if (audioProcessor)
     {
         // First check if we're clicking near an existing band
@@ -229,12 +483,13 @@ void EQInterface::mouseDoubleClick(const juce::MouseEvent& e)
         
         // Update the display
         updateFrequencyResponse();
-        repaint();
     }
 }
 
 void EQInterface::mouseDrag(const juce::MouseEvent& e)
 {
+    syncBandList();
+    
     if (selectedBand != nullptr)
     {
         // Constrain the position to the component bounds
@@ -248,8 +503,11 @@ void EQInterface::mouseDrag(const juce::MouseEvent& e)
 
 void EQInterface::mouseUp(const juce::MouseEvent&)
 {
-    // Keep the band selected until the next mouseDown
-    repaint();
+    // Keep the band selected until the next mouseDown; nothing to redraw
+    if (audioProcessor && gestureSlot >= 0)
+        audioProcessor->endParameterGesture(gestureSlot);
+    
+    gestureSlot = -1;
 }
 
 void EQInterface::addBand(const juce::Point<float>& position)
@@ -281,7 +539,6 @@ void EQInterface::addBand(const juce::Point<float>& position)
         
         // Update the display
         updateFrequencyResponse();
-        repaint();
     }
 }
 
@@ -289,6 +546,9 @@ void EQInterface::removeBand(EQBand* band)
 {
     if (audioProcessor)
     {
+        if (selectedBand == band)
+            selectedBand = nullptr;
+        
         audioProcessor->removeBand(band);
         updateBands();
     }
@@ -304,9 +564,9 @@ void EQInterface::updateBandPosition(EQBand* band, const juce::Point<float>& new
         band->setFrequency(freq);
         band->setGain(gain);
         band->setPosition(newPosition);
+        audioProcessor->updateBandChain();
         
         updateFrequencyResponse();
-        repaint();
     }
 }
 
@@ -319,49 +579,147 @@ void EQInterface::setSampleRate(double newSampleRate)
         {
             band->setSampleRate(sampleRate);
         }
+        audioProcessor->updateBandChain();
         updateFrequencyResponse();
     }
 }
 
-void EQInterface::process(juce::AudioBuffer<float>& buffer)
-{
-    if (fftAnalyzer)
-    {
-        // Process audio through FFT analyzer
-        fftAnalyzer->processAudioBuffer(buffer);
-    }
-}
-
 void EQInterface::updateFrequencyResponse()
 {
     frequencyResponsePath.clear();
     
-    // Start at the minimum frequency
-    float startFreq = 20.0f;
-    float startGain = calculateTotalGain(startFreq);
-    frequencyResponsePath.startNewSubPath(frequencyToX(startFreq), gainToY(startGain));
+    if (!audioProcessor)
+    {
+        drawnNodes.clear();
+        invalidateCurveLayer(getLocalBounds());
+        return;
+    }
+    
+    // Sum the bands' cached dB responses; only bands that changed since the
+    // last update are re-evaluated
+    const int numPoints = EQBand::numResponsePoints;
+    totalResponseDb.assign(static_cast<size_t>(numPoints), 0.0f);
     
-    // Use logarithmically spaced points for frequency
-    const int numPoints = 200;
-    const float minFreq = 20.0f;
-    const float maxFreq = 20000.0f;
+    for (const auto& band : audioProcessor->getBands())
+        juce::FloatVectorOperations::add(totalResponseDb.data(), band->getResponseDb().data(), numPoints);
+    
+    // Ensure the total gain stays within our display limits
+    juce::FloatVectorOperations::clip(totalResponseDb.data(), totalResponseDb.data(), minGain, maxGain, numPoints);
     
-    for (int i = 1; i < numPoints; ++i)
+    curveY.resize(static_cast<size_t>(numPoints));
+    
+    for (int i = 0; i < numPoints; ++i)
     {
-        // Calculate frequency point (logarithmic spacing)
-        float t = static_cast<float>(i) / (numPoints - 1);
-        float freq = minFreq * std::pow(maxFreq/minFreq, t);
+        // Convert to screen coordinates
+        float x = frequencyToX(EQBand::getResponseFrequency(i));
+        float y = gainToY(totalResponseDb[static_cast<size_t>(i)]);
+        curveY[static_cast<size_t>(i)] = y;
         
-        // Calculate the total gain at this frequency
-        float totalGain = calculateTotalGain(freq);
+        if (i == 0)
+            frequencyResponsePath.startNewSubPath(x, y);
+        else
+            frequencyResponsePath.lineTo(x, y);
+    }
+    
+    // Work out which part of the curve layer no longer matches the bands
+    const auto& processorBands = audioProcessor->getBands();
+    const int numBands = static_cast<int>(processorBands.size());
+    bool sameBands = drawnNodes.size() == processorBands.size() && drawnCurveY.size() == curveY.size();
+    
+    for (int i = 0; sameBands && i < numBands; ++i)
+        sameBands = drawnNodes[static_cast<size_t>(i)].id == processorBands[static_cast<size_t>(i)]->getId();
+    
+    juce::Rectangle<int> dirtyArea;
+    
+    if (!sameBands)
+    {
+        dirtyArea = getLocalBounds();
+    }
+    else
+    {
+        // Points whose position changed, widened to the span of any gradient
+        // stop whose colour changed (a band's stop colour follows its type and gain)
+        int firstPoint = numPoints;
+        int lastPoint = -1;
         
-        // Convert to screen coordinates
-        float x = frequencyToX(freq);
-        float y = gainToY(totalGain);
+        for (int i = 0; i < numPoints; ++i)
+        {
+            if (curveY[static_cast<size_t>(i)] != drawnCurveY[static_cast<size_t>(i)])
+            {
+                firstPoint = juce::jmin(firstPoint, i);
+                lastPoint = i;
+            }
+        }
         
-        // Add point to path
-        frequencyResponsePath.lineTo(x, y);
+        for (int i = 0; i < numBands; ++i)
+        {
+            const auto& band = *processorBands[static_cast<size_t>(i)];
+            const auto& drawn = drawnNodes[static_cast<size_t>(i)];
+            const bool moved = drawn.frequency != band.getFrequency() || drawn.gain != band.getGain();
+            const bool recoloured = drawn.gain != band.getGain() || drawn.type != band.getType();
+            const bool relabelled = drawn.target != band.getChannelTarget() || drawn.dynamic != band.getDynamics().enabled;
+            
+            if (moved || recoloured || relabelled || drawn.selected != (&band == selectedBand))
+            {
+                dirtyArea = dirtyArea.getUnion(getNodeArea(drawn.frequency, drawn.gain))
+                                     .getUnion(getNodeArea(band.getFrequency(), band.getGain()));
+            }
+            
+            if (recoloured)
+            {
+                const float spanStart = numBands > 1 ? static_cast<float>(i - 1) / static_cast<float>(numBands - 1) : 0.0f;
+                const float spanEnd = numBands > 1 ? static_cast<float>(i + 1) / static_cast<float>(numBands - 1) : 1.0f;
+                
+                for (int point = 0; point < numPoints; ++point)
+                {
+                    const float position = frequencyToX(EQBand::getResponseFrequency(point)) / static_cast<float>(juce::jmax(1, getWidth()));
+                    
+                    if (position >= spanStart && position <= spanEnd)
+                    {
+                        firstPoint = juce::jmin(firstPoint, point);
+                        lastPoint = juce::jmax(lastPoint, point);
+                    }
+                }
+            }
+        }
+        
+        if (lastPoint >= 0)
+        {
+            // Include the segments joining the changed run to its neighbours
+            firstPoint = juce::jmax(0, firstPoint - 1);
+            lastPoint = juce::jmin(numPoints - 1, lastPoint + 1);
+            
+            float top = curveY[static_cast<size_t>(firstPoint)];
+            float bottom = top;
+            
+            for (int i = firstPoint; i <= lastPoint; ++i)
+            {
+                for (float y : { curveY[static_cast<size_t>(i)], drawnCurveY[static_cast<size_t>(i)] })
+                {
+                    top = juce::jmin(top, y);
+                    bottom = juce::jmax(bottom, y);
+                }
+            }
+            
+            const float left = frequencyToX(EQBand::getResponseFrequency(firstPoint));
+            const float right = frequencyToX(EQBand::getResponseFrequency(lastPoint));
+            
+            // Pad by the stroke width plus antialiasing
+            dirtyArea = dirtyArea.getUnion(juce::Rectangle<float>(left, top, right - left, bottom - top)
+                                               .expanded(3.0f)
+                                               .getSmallestIntegerContainer());
+        }
     }
+    
+    drawnCurveY = curveY;
+    drawnNodes.clear();
+    
+    for (const auto& band : processorBands)
+        drawnNodes.push_back({ band->getId(), band->getFrequency(), band->getGain(), band->getType(),
+                               band->getChannelTarget(), band->getDynamics().enabled, band.get() == selectedBand });
+    
+    if (!dirtyArea.isEmpty())
+        invalidateCurveLayer(dirtyArea);
 }
 
 float EQInterface::calculateTotalGain(float frequency) const
@@ -425,6 +783,27 @@ void EQInterface::drawGridLines(juce::Graphics& g)
     }
 }
 
+void EQInterface::drawAxisLabels(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::white.withAlpha(0.5f));
+    g.setFont(11.0f);
+    
+    // Frequency labels along the bottom edge
+    for (float freq : { 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f, 10000.0f })
+    {
+        float x = frequencyToX(freq);
+        juce::String text = freq >= 1000.0f ? juce::String(freq / 1000.0f, 0) + "k" : juce::String(freq, 0);
+        g.drawText(text, juce::roundToInt(x) - 20, getHeight() - 16, 40, 14, juce::Justification::centred);
+    }
+    
+    // Gain labels along the left edge, matching the grid lines
+    for (float gain = minGain + 6.0f; gain < maxGain; gain += 6.0f)
+    {
+        float y = gainToY(gain);
+        g.drawText(juce::String(gain, 0) + " dB", 4, juce::roundToInt(y) - 14, 50, 14, juce::Justification::bottomLeft);
+    }
+}
+
 void EQInterface::showContextMenu(const juce::Point<int>& position, EQBand* band)
 {
     juce::PopupMenu menu;
@@ -439,6 +818,70 @@ void EQInterface::showContextMenu(const juce::Point<int>& position, EQBand* band
     filterTypeMenu.addItem(6, "High Pass", true, band->getType() == FilterType::HighPass);
     
     menu.addSubMenu("Filter Type", filterTypeMenu);
+    
+    juce::PopupMenu channelMenu;
+    const auto target = band->getChannelTarget();
+    channelMenu.addItem(11, "Stereo", true, target == ChannelTarget::Stereo);
+    channelMenu.addItem(12, "Left", true, target == ChannelTarget::Left);
+    channelMenu.addItem(13, "Right", true, target == ChannelTarget::Right);
+    channelMenu.addItem(14, "Mid", true, target == ChannelTarget::Mid);
+    channelMenu.addItem(15, "Side", true, target == ChannelTarget::Side);
+    
+    menu.addSubMenu("Channels", channelMenu);
+    
+    // Dynamics: ids 40 and 41 toggle, then one range of ids per setting
+    static constexpr float thresholds[] = { -48.0f, -36.0f, -30.0f, -24.0f, -18.0f, -12.0f, -6.0f };
+    static constexpr float ratios[] = { 0.5f, 1.5f, 2.0f, 4.0f, 8.0f };
+    static constexpr float attacks[] = { 1.0f, 5.0f, 10.0f, 30.0f, 100.0f };
+    static constexpr float releases[] = { 30.0f, 100.0f, 300.0f, 1000.0f };
+    
+    const auto& dynamics = band->getDynamics();
+    const bool canBeDynamic = band->getType() == FilterType::Peak || band->getType() == FilterType::LowShelf
+                              || band->getType() == FilterType::HighShelf;
+    juce::PopupMenu dynamicsMenu, thresholdMenu, ratioMenu, attackMenu, releaseMenu;
+    dynamicsMenu.addItem(40, "Enabled", canBeDynamic, dynamics.enabled);
+    dynamicsMenu.addItem(41, "Key from Sidechain", canBeDynamic, dynamics.useSidechain);
+    
+    for (int i = 0; i < static_cast<int>(std::size(thresholds)); ++i)
+        thresholdMenu.addItem(50 + i, juce::String(thresholds[i], 0) + " dB", true, dynamics.threshold == thresholds[i]);
+    
+    for (int i = 0; i < static_cast<int>(std::size(ratios)); ++i)
+        ratioMenu.addItem(60 + i, juce::String(ratios[i], 1) + ":1", true, dynamics.ratio == ratios[i]);
+    
+    for (int i = 0; i < static_cast<int>(std::size(attacks)); ++i)
+        attackMenu.addItem(70 + i, juce::String(attacks[i], 0) + " ms", true, dynamics.attack == attacks[i]);
+    
+    for (int i = 0; i < static_cast<int>(std::size(releases)); ++i)
+        releaseMenu.addItem(80 + i, juce::String(releases[i], 0) + " ms", true, dynamics.release == releases[i]);
+    
+    dynamicsMenu.addSubMenu("Threshold", thresholdMenu);
+    dynamicsMenu.addSubMenu("Ratio", ratioMenu);
+    dynamicsMenu.addSubMenu("Attack", attackMenu);
+    dynamicsMenu.addSubMenu("Release", releaseMenu);
+    
+    menu.addSubMenu("Dynamics", dynamicsMenu);
+    
+    // MIDI tracking: ids 100 + harmonic for the frequency, then 110 + gain source
+    static constexpr const char* harmonicNames[] = { "Off", "Fundamental", "2nd Harmonic", "3rd Harmonic", "4th Harmonic" };
+    static constexpr int gainControllers[] = { 1, 11 };
+    
+    const auto& tracking = band->getTracking();
+    juce::PopupMenu trackingMenu, followMenu, gainMenu;
+    
+    for (int i = 0; i < static_cast<int>(std::size(harmonicNames)); ++i)
+        followMenu.addItem(100 + i, harmonicNames[i], true, tracking.harmonic == i);
+    
+    using GainSource = BandTracking::GainSource;
+    gainMenu.addItem(110, "Fixed", true, tracking.gainSource == GainSource::fixed);
+    gainMenu.addItem(111, "Velocity", true, tracking.gainSource == GainSource::velocity);
+    gainMenu.addItem(112, "Mod Wheel (CC 1)", true,
+                     tracking.gainSource == GainSource::controller && tracking.controller == gainControllers[0]);
+    gainMenu.addItem(113, "Expression (CC 11)", true,
+                     tracking.gainSource == GainSource::controller && tracking.controller == gainControllers[1]);
+    
+    trackingMenu.addSubMenu("Follow Note", followMenu);
+    trackingMenu.addSubMenu("Gain", gainMenu);
+    menu.addSubMenu("MIDI Tracking", trackingMenu);
     menu.addSeparator();
     menu.addItem(7, "Delete");
     
@@ -447,8 +890,12 @@ void EQInterface::showContextMenu(const juce::Point<int>& position, EQBand* band
         .withTargetScreenArea(juce::Rectangle<int>(position.x - 1, position.y - 1, 2, 2))
         .withMinimumWidth(120)
         .withPreferredPopupDirection(juce::PopupMenu::Options::PopupDirection::downwards),
-        [this, band](int result)
+        [this, band, serial = bandListSerial](int result)
         {
+            // A session recalled while the menu was open took the band with it
+            if (audioProcessor && audioProcessor->getBandListSerial() != serial)
+                return;
+            
             if (result > 0)
             {
                 switch (result)
@@ -460,8 +907,178 @@ void EQInterface::showContextMenu(const juce::Point<int>& position, EQBand* band
                     case 5: band->setType(FilterType::LowPass); break;
                     case 6: band->setType(FilterType::HighPass); break;
                     case 7: removeBand(band); break;
+                    case 11: band->setChannelTarget(ChannelTarget::Stereo); break;
+                    case 12: band->setChannelTarget(ChannelTarget::Left); break;
+                    case 13: band->setChannelTarget(ChannelTarget::Right); break;
+                    case 14: band->setChannelTarget(ChannelTarget::Mid); break;
+                    case 15: band->setChannelTarget(ChannelTarget::Side); break;
+                }
+                
+                if (result >= 40 && result < 90)
+                {
+                    auto dynamics = band->getDynamics();
+                    
+                    if (result == 40)       dynamics.enabled = !dynamics.enabled;
+                    else if (result == 41)  dynamics.useSidechain = !dynamics.useSidechain;
+                    else if (result >= 80)  dynamics.release = releases[result - 80];
+                    else if (result >= 70)  dynamics.attack = attacks[result - 70];
+                    else if (result >= 60)  dynamics.ratio = ratios[result - 60];
+                    else if (result >= 50)  dynamics.threshold = thresholds[result - 50];
+                    
+                    band->setDynamics(dynamics);
+                }
+                
+                if (result >= 100 && result < 120)
+                {
+                    auto tracking = band->getTracking();
+                    
+                    if (result >= 112)
+                    {
+                        tracking.gainSource = BandTracking::GainSource::controller;
+                        tracking.controller = gainControllers[result - 112];
+                    }
+                    else if (result >= 110)
+                    {
+                        tracking.gainSource = result == 111 ? BandTracking::GainSource::velocity
+                                                            : BandTracking::GainSource::fixed;
+                    }
+                    else
+                    {
+                        tracking.harmonic = result - 100;
+                    }
+                    
+                    band->setTracking(tracking);
                 }
+                
+                if (result != 7)
+                    audioProcessor->updateBandChain();
+                
+                updateBands();
+            }
+        });
+}
+
+void EQInterface::showSettingsMenu(const juce::Point<int>& position)
+{
+    juce::PopupMenu menu;
+    
+    // Oversampling only engages for bands high enough to need it
+    // (only used by the minimum-phase biquads)
+    const bool linearPhase = audioProcessor->isLinearPhaseEnabled();
+    juce::PopupMenu oversamplingMenu;
+    const int currentOrder = audioProcessor->getOversamplingOrder();
+    oversamplingMenu.addItem(1, "Off", !linearPhase, currentOrder == 0);
+    oversamplingMenu.addItem(2, "2x", !linearPhase, currentOrder == 1);
+    oversamplingMenu.addItem(3, "4x", !linearPhase, currentOrder == 2);
+    oversamplingMenu.addItem(4, "8x", !linearPhase, currentOrder == 3);
+    
+    menu.addSubMenu("Oversampling", oversamplingMenu);
+    menu.addSeparator();
+    menu.addItem(10, "Linear Phase", true, linearPhase);
+    
+    // State-variable bands track fast automation and modulation cleanly
+    // (again only in the minimum-phase path)
+    const bool stateVariable = audioProcessor->getFilterTopology() == FilterTopology::StateVariable;
+    menu.addItem(11, "State-Variable Filters", !linearPhase, stateVariable);
+    
+    // Larger partitions cost less CPU but add latency
+    juce::PopupMenu partitionMenu;
+    const int currentPartitionSize = audioProcessor->getLinearPhasePartitionSize();
+    
+    for (int i = 0; i < 5; ++i)
+    {
+        const int partitionSize = 256 << i;
+        partitionMenu.addItem(20 + i, juce::String(partitionSize) + " samples", true, currentPartitionSize == partitionSize);
+    }
+    
+    menu.addSubMenu("Linear Phase Block Size", partitionMenu);
+    menu.addSeparator();
+    menu.addItem(30, "Show DSP Load", true, showDspLoad);
+    menu.addItem(31, "Reset DSP Load Statistics");
+    menu.addSeparator();
+    
+    // A/B snapshots: recalling glides to one, the morph moves between them
+    juce::PopupMenu snapshotMenu, morphMenu;
+    const bool canMorph = audioProcessor->hasSnapshot(0) && audioProcessor->hasSnapshot(1);
+    snapshotMenu.addItem(40, "Store A");
+    snapshotMenu.addItem(41, "Store B");
+    snapshotMenu.addSeparator();
+    snapshotMenu.addItem(42, "Recall A", audioProcessor->hasSnapshot(0));
+    snapshotMenu.addItem(43, "Recall B", audioProcessor->hasSnapshot(1));
+    
+    for (int i = 0; i <= 4; ++i)
+    {
+        const bool current = audioProcessor->isMorphing() && audioProcessor->getMorphPosition() == static_cast<float>(i) * 0.25f;
+        morphMenu.addItem(50 + i, juce::String(i * 25) + "% B", canMorph, current);
+    }
+    
+    snapshotMenu.addSubMenu("Morph", morphMenu, canMorph);
+    menu.addSubMenu("Snapshots", snapshotMenu);
+    menu.addSeparator();
+    
+    // The whole state as XML, for diffing sessions or moving settings between instances
+    menu.addItem(32, "Copy Settings as XML");
+    menu.addItem(33, "Paste Settings");
+    
+    menu.showMenuAsync(juce::PopupMenu::Options()
+        .withTargetScreenArea(juce::Rectangle<int>(position.x - 1, position.y - 1, 2, 2))
+        .withMinimumWidth(120),
+        [this, linearPhase, stateVariable](int result)
+        {
+            if (result <= 0 || !audioProcessor)
+                return;
+            
+            if (result <= 4)
+                audioProcessor->setOversamplingOrder(result - 1);
+            else if (result == 10)
+                audioProcessor->setLinearPhaseEnabled(!linearPhase);
+            else if (result == 11)
+                audioProcessor->setFilterTopology(stateVariable ? FilterTopology::Biquad : FilterTopology::StateVariable);
+            else if (result >= 20 && result < 25)
+                audioProcessor->setLinearPhasePartitionSize(256 << (result - 20));
+            else if (result == 30)
+            {
+                showDspLoad = !showDspLoad;
+                invalidate(getLoadOverlayArea());
+                
+                if (showDspLoad)
+                    updateLoadOverlay();
+            }
+            else if (result == 31)
+            {
+                audioProcessor->resetDspLoadStatistics();
+                previousLoadStatistics = loadStatistics = {};
+            }
+            else if (result == 40 || result == 41)
+            {
+                audioProcessor->storeSnapshot(result - 40);
+            }
+            else if (result == 42 || result == 43)
+            {
+                audioProcessor->recallSnapshot(result - 42);
+                syncBandList();
+                updateBands();
+            }
+            else if (result >= 50 && result <= 54)
+            {
+                audioProcessor->setMorphPosition(static_cast<float>(result - 50) * 0.25f);
+                syncBandList();
                 updateBands();
             }
+            else if (result == 32)
+            {
+                juce::SystemClipboard::copyTextToClipboard(audioProcessor->getState().toXml()->toString());
+            }
+            else if (result == 33)
+            {
+                PluginState state;
+                const auto xml = juce::XmlDocument::parse(juce::SystemClipboard::getTextFromClipboard());
+                
+                if (xml != nullptr && state.fromXml(*xml).isEmpty())
+                {
+                    audioProcessor->setState(state);
+                    syncBandList();
+                }
+            }
         });
-} 
\ No newline at end of file
+}
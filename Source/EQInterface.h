@@ -6,12 +6,12 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include "EQBand.h"
 #include "FFT.h"
+#include "DspLoad.h"
 
 // Forward declaration
 class SondyEQAudioProcessor;
 
-class EQInterface : public juce::Component,
-                    private juce::Timer
+class EQInterface : public juce::Component
 {
 public:
     EQInterface();
@@ -25,30 +25,78 @@ public:
     void mouseDrag(const juce::MouseEvent&) override;
     void mouseUp(const juce::MouseEvent&) override;
     
-    void setProcessor(SondyEQAudioProcessor* processor) { audioProcessor = processor; }
+    void setProcessor(SondyEQAudioProcessor* processor);
     void updateBands();
     
     void setSampleRate(double newSampleRate);
-    void process(juce::AudioBuffer<float>& buffer);
     
     float calculateTotalGain(float frequency) const;
 
 private:
-    void timerCallback() override;
+    // Frame scheduling: changes only mark areas dirty, and the union is
+    // repainted once per display refresh. Nothing dirty means no repaint.
+    void onVBlank();
+    void invalidate(juce::Rectangle<int> area);
+    juce::Rectangle<int> pendingRepaint;
     void showContextMenu(const juce::Point<int>& position, EQBand* band);
+    void showSettingsMenu(const juce::Point<int>& position);
     
     SondyEQAudioProcessor* audioProcessor = nullptr;
     EQBand* selectedBand = nullptr;
+    
+    // The processor's band list serial as of the last sync; a host restoring
+    // a session replaces the band list under the editor
+    juce::uint32 bandListSerial = 0;
+    juce::uint32 bandSettingsSerial = 0;
+    void syncBandList();
+    
+    // The parameter slot of the band being dragged, -1 outside a drag
+    int gestureSlot = -1;
     double sampleRate = 44100.0;
     bool isDragging = false;
     
     // FFT related members (updated to multichannel)
     std::unique_ptr<SondyFFT::MultiChannelFFTSpectrumAnalyzer> fftAnalyzer;
     std::unique_ptr<SondyFFT::MultiChannelSpectrumComponent> spectrumComponent;
+    std::unique_ptr<SondyFFT::AnalysisThread> analysisThread;
     
     juce::Path frequencyResponsePath;
+    std::vector<float> totalResponseDb;
     void updateFrequencyResponse();
     void drawGridLines(juce::Graphics& g);
+    void drawAxisLabels(juce::Graphics& g);
+    
+    // Cached render layers: the grid (background, grid lines, axis labels) is
+    // rebuilt only on resize, the curve (response and band nodes) only where
+    // the bands or the selection changed
+    float getLayerScale() const;
+    juce::Rectangle<int> getLayerPixelBounds(float scale) const;
+    void renderGridLayer(float scale);
+    void renderCurveLayer(float scale);
+    void invalidateCurveLayer(juce::Rectangle<int> area);
+    
+    juce::Image gridLayer;
+    juce::Image curveLayer;
+    juce::Rectangle<int> curveLayerDirtyArea;
+    
+    // What the curve layer currently shows, used to work out which part of
+    // it a band change invalidates
+    struct NodeState
+    {
+        juce::uint32 id;
+        float frequency;
+        float gain;
+        FilterType type;
+        ChannelTarget target;
+        bool dynamic;
+        bool selected;
+    };
+    
+    std::vector<NodeState> drawnNodes;
+    std::vector<float> drawnCurveY;
+    std::vector<float> curveY;
+    juce::Rectangle<int> getNodeArea(float frequency, float gain) const;
+    static const char* getChannelTargetInitial(ChannelTarget target);
     
     float frequencyToX(float freq) const;
     float gainToY(float gain) const;
@@ -63,4 +111,18 @@ private:
     void addBand(const juce::Point<float>& position);
     void removeBand(EQBand* band);
     void updateBandPosition(EQBand* band, const juce::Point<float>& newPosition);
+    
+    // DSP load overlay, toggled from the settings menu. It samples the
+    // processor's counters a few times a second and only repaints itself.
+    static constexpr juce::uint32 loadOverlayIntervalMs = 250;
+    bool showDspLoad = false;
+    juce::uint32 lastLoadOverlayUpdate = 0;
+    DspLoadStatistics previousLoadStatistics, loadStatistics;
+    double recentLoad = 0.0;
+    juce::Rectangle<int> getLoadOverlayArea() const;
+    void updateLoadOverlay();
+    void drawLoadOverlay(juce::Graphics& g);
+    
+    // Declared last so it is detached before anything it calls into is destroyed
+    juce::VBlankAttachment vBlankAttachment { this, [this] { onVBlank(); } };
 }; 
\ No newline at end of file
@@ -15,12 +15,33 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
+#include <cstring>
+#include <functional>
 #include <vector>
 #include <memory>
+#include "LockFree.h"
 
 
 namespace SondyFFT {
 
+/** Branch-free log2 approximation (about 0.01 error), written so that a loop
+    over a plain array auto-vectorizes: exponent from the float bits plus a
+    quadratic fit of 1 + log2 over the mantissa in [1, 2).
+*/
+inline float fastLog2 (float x) noexcept
+{
+    juce::uint32 bits;
+    std::memcpy (&bits, &x, sizeof (bits));
+
+    const auto exponent = static_cast<float> (static_cast<int> (bits >> 23) - 128);
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+
+    float mantissa;
+    std::memcpy (&mantissa, &bits, sizeof (mantissa));
+
+    return exponent + (-0.34484843f * mantissa + 2.02466578f) * mantissa - 0.67487759f;
+}
+
 class FFTSpectrumAnalyzer
 {
 public:
@@ -30,36 +51,63 @@ public:
     FFTSpectrumAnalyzer (int fftOrder_)
     : fftOrder (fftOrder_),
     fftSize (1 << fftOrder_),
+    hopSize (fftSize / 4),
     fft (fftOrder_),
     window (fftSize, juce::dsp::WindowingFunction<float>::hann)
     {
         // Allocate space for FFT data.
         // We use a buffer of size 2*fftSize because JUCE's performRealOnlyForwardTransform expects that.
         fftData.resize (2 * fftSize, 0.0f);
-        fifoBuffer.resize (fftSize, 0.0f);
+        history.resize (fftSize, 0.0f);
+        power.resize (fftSize / 2 + 1, 0.0f);
+        magnitudesDb.resize (fftSize / 2 + 1, minDecibels);
     }
     
-    /** Pushes the next sample into the internal FIFO.
-     When the FIFO is full, an FFT is performed.
+    /** Sets how far the analysis window advances between frames.
+     fftSize / 2, / 4 and / 8 give 50%, 75% and 87.5% overlap.
+     */
+    void setHopSize (int newHopSize)
+    {
+        hopSize = juce::jlimit (1, fftSize, newHopSize);
+    }
+    
+    int getHopSize() const { return hopSize; }
+    
+    /** Pushes the next sample into the circular history.
+     Every hopSize samples, an FFT of the latest fftSize samples is performed.
      */
     void pushNextSample (float sample)
     {
-        fifoBuffer[fifoIndex++] = sample;
+        history[writeIndex] = sample;
+        writeIndex = (writeIndex + 1) & (fftSize - 1);
         
-        if (fifoIndex == fftSize)
+        if (++samplesSinceLastFrame >= hopSize)
         {
-            // Copy FIFO to fftData and apply windowing.
-            std::copy (fifoBuffer.begin(), fifoBuffer.end(), fftData.begin());
-            window.multiplyWithWindowingTable (fftData.data(), fftSize);
-            
-            // Perform the FFT in-place. The output is stored in fftData.
-            fft.performRealOnlyForwardTransform (fftData.data());
+            samplesSinceLastFrame = 0;
+            performFrame();
+        }
+    }
+    
+    /** Pushes a run of samples, copying into the history in bulk between frames. */
+    void pushSamples (const float* samples, int numSamples)
+    {
+        while (numSamples > 0)
+        {
+            const int untilFrame = hopSize - samplesSinceLastFrame;
+            const int untilWrap = fftSize - writeIndex;
+            const int count = juce::jmin (numSamples, untilFrame, untilWrap);
             
-            // Mark that new FFT data is available.
-            newFFTDataAvailable = true;
+            std::copy (samples, samples + count, history.begin() + writeIndex);
+            writeIndex = (writeIndex + count) & (fftSize - 1);
+            samplesSinceLastFrame += count;
+            samples += count;
+            numSamples -= count;
             
-            // Reset FIFO index for the next block.
-            fifoIndex = 0;
+            if (samplesSinceLastFrame >= hopSize)
+            {
+                samplesSinceLastFrame = 0;
+                performFrame();
+            }
         }
     }
     
@@ -79,37 +127,18 @@ public:
         newFFTDataAvailable = false;
     }
     
-    /** Returns the magnitude (or amplitude) for a given frequency bin.
-     Note: For a real-input FFT performed with performRealOnlyForwardTransform,
-     the format of the output data is a little different:
-     - bin 0 is stored in fftData[0] (real only),
-     - bin fftSize/2 is stored in fftData[1] (real only),
-     - bins 1 .. (fftSize/2 - 1) are stored as real/imaginary pairs.
+    /** Returns true if every bin of the latest frame sits at the floor.
      */
-    float getMagnitudeForBin (int binIndex) const
+    bool isSilent() const
     {
-        jassert (binIndex >= 0 && binIndex <= fftSize / 2);
-        
-        float magnitude;
-        
-        if (binIndex == 0)
-            magnitude = std::abs(fftData[0]);
-        else if (binIndex == fftSize / 2)
-            magnitude = std::abs(fftData[1]);
-        else
-        {
-            int realIndex = binIndex * 2;
-            int imagIndex = realIndex + 1;
-            float real = fftData[realIndex];
-            float imag = fftData[imagIndex];
-            
-            magnitude = std::sqrt(real * real + imag * imag);
-        }
-        
-        // Scale the magnitude by the FFT size to normalize
-        return magnitude * 2.0f / fftSize;
+        return frameIsSilent;
     }
     
+    /** Returns the level of every bin (0 .. fftSize/2) of the latest frame in dB,
+     normalised so a full-scale sine reads 0 dB and floored at minDecibels.
+     */
+    const std::vector<float>& getMagnitudesDb() const { return magnitudesDb; }
+    
     /** Returns the size of the FFT (number of input samples per FFT).
      */
     int getFFTSize() const { return fftSize; }
@@ -119,20 +148,65 @@ public:
      */
     const std::vector<float>& getFFTData() const { return fftData; }
     
+    static constexpr float minDecibels = -100.0f;
+    
 private:
     int fftOrder;
     int fftSize;
+    int hopSize;
     
     // JUCE FFT and windowing objects.
     juce::dsp::FFT fft;
     juce::dsp::WindowingFunction<float> window;
     
-    // Buffers for input and FFT data.
-    std::vector<float> fifoBuffer;
+    // Circular input history and FFT working buffers.
+    std::vector<float> history;
     std::vector<float> fftData;
+    std::vector<float> power;
+    std::vector<float> magnitudesDb;
     
-    int fifoIndex { 0 };
+    int writeIndex { 0 };
+    int samplesSinceLastFrame { 0 };
     bool newFFTDataAvailable { false };
+    bool frameIsSilent { true };
+    
+    void performFrame()
+    {
+        // Unroll the circular history, oldest sample first, and apply the window.
+        const auto split = history.begin() + writeIndex;
+        std::copy (split, history.end(), fftData.begin());
+        std::copy (history.begin(), split, fftData.begin() + (history.end() - split));
+        window.multiplyWithWindowingTable (fftData.data(), static_cast<size_t> (fftSize));
+        
+        // Perform the FFT in-place. The output is fftSize / 2 + 1 interleaved
+        // complex bins: fftData[2k] is the real part, fftData[2k + 1] the imaginary.
+        fft.performRealOnlyForwardTransform (fftData.data(), true);
+        
+        // One pass each for squared magnitude and dB, both over plain arrays.
+        // Scaling by 2 / fftSize normalises a full-scale sine to 0 dB; the floor
+        // is folded into the power so the log never sees zero.
+        const int numBins = fftSize / 2 + 1;
+        const float scale = 2.0f / static_cast<float> (fftSize);
+        const float powerScale = scale * scale;
+        const float powerFloor = std::pow (10.0f, minDecibels / 10.0f);
+        const float* bins = fftData.data();
+        float* p = power.data();
+        
+        for (int k = 0; k < numBins; ++k)
+            p[k] = juce::jmax (powerFloor, (bins[2 * k] * bins[2 * k] + bins[2 * k + 1] * bins[2 * k + 1]) * powerScale);
+        
+        frameIsSilent = juce::FloatVectorOperations::findMaximum (p, numBins) <= powerFloor;
+        
+        // 10 log10(x) = (10 / log2(10)) log2(x)
+        constexpr float dbPerLog2 = 3.01029996f;
+        float* db = magnitudesDb.data();
+        
+        for (int k = 0; k < numBins; ++k)
+            db[k] = dbPerLog2 * fastLog2 (p[k]);
+        
+        // Mark that new FFT data is available.
+        newFFTDataAvailable = true;
+    }
 };
 
 class SpectrumComponent : public juce::Component
@@ -169,6 +243,7 @@ public:
         // Get FFT parameters
         const int fftSize = analyzer->getFFTSize();
         const int numBins = fftSize / 2;
+        const float* levels = analyzer->getMagnitudesDb().data();
         
         juce::Path spectrumPath;
         bool firstPoint = true;
@@ -176,11 +251,8 @@ public:
         // Iterate through the frequency bins
         for (int bin = 0; bin < numBins; ++bin)
         {
-            // Get the magnitude for this bin
-            float magnitude = analyzer->getMagnitudeForBin(bin);
-            
-            // Convert magnitude to decibels with a reference level adjustment
-            float dB = juce::Decibels::gainToDecibels(magnitude, -100.0f);
+            // Level of this bin, already in decibels
+            float dB = levels[bin];
             
             // Normalize the dB value to a 0...1 range with adjusted range
             float normalizedMagnitude = juce::jlimit(0.0f, 1.0f, (dB + 100.0f) / 100.0f);
@@ -214,6 +286,16 @@ private:
     FFTSpectrumAnalyzer* analyzer;
 };
 
+/** One finished set of spectra, handed from the analysis thread to the GUI.
+    Levels are in dB and stored as [channel * numBins + bin].
+*/
+struct SpectrumFrame
+{
+    std::vector<float> decibels;
+    int numBins = 0;
+    float sampleRate = 44100.0f;
+};
+
 class MultiChannelFFTSpectrumAnalyzer
 {
 public:
@@ -225,7 +307,8 @@ public:
         : numChannels (numChannels_),
           fftOrder (fftOrder_),
           fftSize (1 << fftOrder_),
-          sampleRate(44100.0f)  // Default sample rate
+          sampleRate(44100.0f),  // Default sample rate
+          frames (makeEmptyFrame (numChannels_, (1 << fftOrder_) / 2 + 1))
     {
         for (int i = 0; i < numChannels; ++i)
         {
@@ -233,12 +316,14 @@ public:
         }
     }
 
+    /** Analysis thread: sets the rate stamped on published frames. */
     void setSampleRate(float newSampleRate)
     {
         sampleRate = newSampleRate;
     }
 
-    float getSampleRate() const { return sampleRate; }
+    /** GUI thread: the sample rate of the current frame. */
+    float getSampleRate() const { return frames.getReadBuffer().sampleRate; }
 
     /** Pushes one sample for a specific channel into its analyzer. */
     void pushNextSample (int channel, float sample)
@@ -247,23 +332,78 @@ public:
         analyzers[channel]->pushNextSample(sample);
     }
 
-    /** Convenience method: Processes an entire audio buffer.
-        It pushes each sample of each channel (up to numChannels) into the corresponding analyzer.
+    /** Any thread: requests a new hop size, picked up by the analysis thread.
+        fftSize / 2, / 4 and / 8 give 50%, 75% and 87.5% overlap.
     */
-    void processAudioBuffer (const juce::AudioBuffer<float>& buffer)
+    void setHopSize (int newHopSize)
+    {
+        requestedHopSize = juce::jlimit (1, fftSize, newHopSize);
+    }
+
+    /** Analysis thread: pushes a run of planar samples into the per-channel analyzers. */
+    void processSamples (const float* const* data, int channels, int numSamples)
     {
-        const int channels = buffer.getNumChannels();
-        const int samples = buffer.getNumSamples();
         const int processChannels = juce::jmin (channels, numChannels);
+        const int hopSize = requestedHopSize.load();
 
         for (int ch = 0; ch < processChannels; ++ch)
         {
-            const float* data = buffer.getReadPointer (ch);
-            for (int i = 0; i < samples; ++i)
-                pushNextSample (ch, data[i]);
+            if (analyzers[ch]->getHopSize() != hopSize)
+                analyzers[ch]->setHopSize (hopSize);
+
+            analyzers[ch]->pushSamples (data[ch], numSamples);
         }
     }
 
+    /** Analysis thread: if any channel finished an FFT, copies all spectra
+        into a frame and publishes it to the GUI. Once a silent frame has been
+        published, further silent frames are dropped so an idle GUI has
+        nothing to redraw.
+    */
+    void publishIfNewData()
+    {
+        bool anyNewData = false;
+        bool allSilent = true;
+        for (auto& channelAnalyzer : analyzers)
+        {
+            anyNewData = anyNewData || channelAnalyzer->isNewDataAvailable();
+            allSilent = allSilent && channelAnalyzer->isSilent();
+        }
+
+        if (!anyNewData)
+            return;
+
+        if (allSilent && publishedSilence)
+        {
+            for (auto& channelAnalyzer : analyzers)
+                channelAnalyzer->resetNewDataFlag();
+
+            return;
+        }
+
+        publishedSilence = allSilent;
+
+        auto& frame = frames.getWriteBuffer();
+        frame.sampleRate = sampleRate;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& channelAnalyzer = *analyzers[ch];
+            const auto& levels = channelAnalyzer.getMagnitudesDb();
+
+            std::copy (levels.begin(), levels.end(), frame.decibels.begin() + ch * frame.numBins);
+            channelAnalyzer.resetNewDataFlag();
+        }
+
+        frames.publish();
+    }
+
+    /** GUI thread: swaps in the newest published frame. Returns true if it changed. */
+    bool fetchLatestFrame() { return frames.fetch(); }
+
+    /** GUI thread: true if a frame has been published since the last fetch. */
+    bool hasNewFrame() const { return frames.hasNewFrame(); }
+
     /** Returns the FFT analyzer for a given channel. */
     FFTSpectrumAnalyzer& getAnalyzer (int channel)
     {
@@ -280,13 +420,12 @@ public:
     int getNumChannels() const { return numChannels; }
     int getFFTSize() const { return fftSize; }
 
-    float getMagnitudeForBin(int channel, int binIndex) const
+    /** GUI thread: the dB levels of bins 0 .. fftSize/2 for a channel in the current frame. */
+    const float* getDecibels (int channel) const
     {
-        if (channel >= 0 && channel < numChannels)
-        {
-            return analyzers[channel]->getMagnitudeForBin(binIndex);
-        }
-        return 0.0f;
+        jassert (channel >= 0 && channel < numChannels);
+        const auto& frame = frames.getReadBuffer();
+        return frame.decibels.data() + channel * frame.numBins;
     }
 
 private:
@@ -295,6 +434,77 @@ private:
     int fftSize;
     float sampleRate;
     std::vector<std::unique_ptr<FFTSpectrumAnalyzer>> analyzers;
+    TripleBuffer<SpectrumFrame> frames;
+    std::atomic<int> requestedHopSize { fftSize / 4 };
+    bool publishedSilence = true;  // the initial frame is all floor
+
+    static SpectrumFrame makeEmptyFrame (int channels, int bins)
+    {
+        SpectrumFrame frame;
+        frame.decibels.assign (static_cast<size_t>(channels * bins), FFTSpectrumAnalyzer::minDecibels);
+        frame.numBins = bins;
+        return frame;
+    }
+};
+
+/** Runs the FFT, windowing and magnitude work away from the audio thread.
+
+    The audio thread only copies blocks into an SpscAudioRing; this thread
+    drains it into the analyzer every few milliseconds and publishes finished
+    frames through the analyzer's triple buffer.
+*/
+class AnalysisThread : public juce::Thread
+{
+public:
+    AnalysisThread (SpscAudioRing& sourceRing,
+                    MultiChannelFFTSpectrumAnalyzer& analyzerRef,
+                    std::function<double()> sampleRateSource)
+        : juce::Thread ("SondyEQ Analyzer"),
+          source (sourceRing),
+          analyzer (analyzerRef),
+          getSourceSampleRate (std::move (sampleRateSource)),
+          scratch (static_cast<size_t>(analyzerRef.getNumChannels()), std::vector<float> (chunkSize, 0.0f))
+    {
+        for (auto& channel : scratch)
+            scratchPointers.push_back (channel.data());
+    }
+
+    ~AnalysisThread() override
+    {
+        stopThread (1000);
+    }
+
+    void run() override
+    {
+        const auto channels = static_cast<int>(scratchPointers.size());
+
+        while (!threadShouldExit())
+        {
+            analyzer.setSampleRate (static_cast<float>(getSourceSampleRate()));
+
+            for (;;)
+            {
+                const auto numRead = source.pop (scratchPointers.data(), channels, chunkSize);
+                if (numRead == 0)
+                    break;
+
+                analyzer.processSamples (scratchPointers.data(), channels, numRead);
+            }
+
+            analyzer.publishIfNewData();
+            wait (pollIntervalMs);
+        }
+    }
+
+private:
+    static constexpr int chunkSize = 1024;
+    static constexpr int pollIntervalMs = 5;
+
+    SpscAudioRing& source;
+    MultiChannelFFTSpectrumAnalyzer& analyzer;
+    std::function<double()> getSourceSampleRate;
+    std::vector<std::vector<float>> scratch;
+    std::vector<float*> scratchPointers;
 };
 
 class MultiChannelSpectrumComponent : public juce::Component
@@ -318,53 +528,69 @@ public:
         repaint();
     }
 
+    void resized() override
+    {
+        rebuildColumnMap();
+    }
+
+    /** Draws the analyzer's current frame. The owner calls
+        analyzer.fetchLatestFrame() when it schedules a repaint, so a partial
+        repaint never swaps in a frame that the rest of the area won't show.
+    */
     void paint (juce::Graphics& g) override
     {
-        auto bounds = getLocalBounds().toFloat();
-        const float sampleRate = analyzer.getSampleRate();
+        // The mapping only depends on width, sample rate and FFT size
+        if (mappedWidth != getWidth()
+            || mappedSampleRate != analyzer.getSampleRate()
+            || mappedFFTSize != analyzer.getFFTSize())
+            rebuildColumnMap();
+        
+        const auto bounds = getLocalBounds().toFloat();
+        const int numColumns = static_cast<int>(columnMap.size());
         
         for (int channel = 0; channel < analyzer.getNumChannels(); ++channel)
         {
-            juce::Path fftPath;
-            bool pathStarted = false;
+            const float* levels = analyzer.getDecibels(channel);
             
-            const int numBins = analyzer.getFFTSize() / 2;
-            const float minFreq = 20.0f;
-            const float maxFreq = 20000.0f;
-            
-            for (int i = 0; i < numBins; ++i)
+            // Reduce each pixel column to one value: the peak of the bins it
+            // covers, or an interpolated level where a bin spans several columns
+            for (int column = 0; column < numColumns; ++column)
             {
-                // Calculate frequency for this bin
-                float freq = (i * sampleRate) / (2.0f * numBins);
-                
-                // Skip bins outside our frequency range
-                if (freq < minFreq || freq > maxFreq)
-                    continue;
+                const auto& bins = columnMap[static_cast<size_t>(column)];
+                float dB;
                 
-                // Get magnitude for this bin
-                float magnitude = analyzer.getMagnitudeForBin(channel, i);
-                
-                // Convert to decibels with a reference level adjustment
-                float dB = juce::Decibels::gainToDecibels(magnitude, -100.0f);
+                if (bins.numBins == 0)
+                {
+                    dB = levels[bins.firstBin] + bins.weight * (levels[bins.firstBin + 1] - levels[bins.firstBin]);
+                }
+                else
+                {
+                    dB = levels[bins.firstBin];
+                    for (int bin = bins.firstBin + 1; bin < bins.firstBin + bins.numBins; ++bin)
+                        dB = juce::jmax(dB, levels[bin]);
+                }
                 
+                columnLevels[static_cast<size_t>(column)] = dB;
+            }
+            
+            // At most one point per pixel column
+            juce::Path fftPath;
+            fftPath.preallocateSpace(3 * numColumns);
+            
+            for (int column = 0; column < numColumns; ++column)
+            {
                 // Normalize the dB value to a 0...1 range
-                float normalizedMagnitude = juce::jlimit(0.0f, 1.0f, (dB + 100.0f) / 100.0f);
+                float normalizedMagnitude = juce::jlimit(0.0f, 1.0f, (columnLevels[static_cast<size_t>(column)] + 100.0f) / 100.0f);
                 
-                // Map frequency to x position (logarithmic)
-                float x = std::log(freq / minFreq) / std::log(maxFreq / minFreq) * bounds.getWidth();
+                float x = static_cast<float>(column) + 0.5f;
                 
                 // Map the normalized magnitude to a y position, with a vertical offset
                 float y = (1.0f - normalizedMagnitude) * bounds.getHeight() * 1.0f + bounds.getHeight() * 0.35f;
                 
-                if (!pathStarted)
-                {
+                if (column == 0)
                     fftPath.startNewSubPath(x, y);
-                    pathStarted = true;
-                }
                 else
-                {
                     fftPath.lineTo(x, y);
-                }
             }
             
             // Draw the path with a semi-transparent color
@@ -375,14 +601,84 @@ public:
         }
     }
 
+    /** The part of the component the spectrum can draw into; everything
+        above it stays untouched, so repaints can be limited to this area.
+    */
+    juce::Rectangle<int> getSpectrumArea() const
+    {
+        const int top = juce::jmax(0, static_cast<int>(getHeight() * 0.35f) - 1);
+        return { 0, top, getWidth(), getHeight() - top };
+    }
+
     juce::Colour getChannelColour(int channel) const
     {
         return channel == 0 ? juce::Colours::cyan : juce::Colours::magenta;
     }
 
 private:
+    /** The FFT bins that land in one pixel column. numBins == 0 means the column
+        sits between firstBin and firstBin + 1 and is interpolated by weight.
+    */
+    struct ColumnBins
+    {
+        int firstBin = 0;
+        int numBins = 0;
+        float weight = 0.0f;
+    };
+
     MultiChannelFFTSpectrumAnalyzer& analyzer;
     bool overlayMode = true;
+    
+    std::vector<ColumnBins> columnMap;
+    std::vector<float> columnLevels;
+    int mappedWidth = 0;
+    float mappedSampleRate = 0.0f;
+    int mappedFFTSize = 0;
+    
+    void rebuildColumnMap()
+    {
+        const float minFreq = 20.0f;
+        const float maxFreq = 20000.0f;
+        
+        mappedWidth = getWidth();
+        mappedSampleRate = analyzer.getSampleRate();
+        mappedFFTSize = analyzer.getFFTSize();
+        
+        const int lastBin = mappedFFTSize / 2;
+        const float binsPerHz = static_cast<float>(mappedFFTSize) / mappedSampleRate;
+        const float maxBin = static_cast<float>(lastBin - 1);
+        
+        columnMap.assign(static_cast<size_t>(juce::jmax(0, mappedWidth)), {});
+        columnLevels.assign(columnMap.size(), FFTSpectrumAnalyzer::minDecibels);
+        
+        // Fractional bin position of a column edge on the log frequency axis
+        auto binAt = [&](float column)
+        {
+            const float freq = minFreq * std::pow(maxFreq / minFreq, column / static_cast<float>(mappedWidth));
+            return juce::jlimit(0.0f, maxBin, freq * binsPerHz);
+        };
+        
+        for (int column = 0; column < mappedWidth; ++column)
+        {
+            auto& bins = columnMap[static_cast<size_t>(column)];
+            const float start = binAt(static_cast<float>(column));
+            const float end = binAt(static_cast<float>(column + 1));
+            const int first = static_cast<int>(std::ceil(start));
+            const int last = static_cast<int>(std::floor(end));
+            
+            if (last >= first && end - start >= 1.0f)
+            {
+                bins.firstBin = first;
+                bins.numBins = juce::jmin(last, lastBin) - first + 1;
+            }
+            else
+            {
+                const float centre = binAt(static_cast<float>(column) + 0.5f);
+                bins.firstBin = juce::jmin(static_cast<int>(centre), lastBin - 1);
+                bins.weight = centre - static_cast<float>(bins.firstBin);
+            }
+        }
+    }
 };
 
 
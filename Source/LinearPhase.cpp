@@ -0,0 +1,423 @@
+#include "LinearPhase.h"
+#include <cmath>
+
+namespace LinearPhaseDesign
+{
+
+std::unique_ptr<LinearPhaseKernel> createKernel(const std::vector<BiquadDesign::Parameters>& bands,
+                                                double sampleRate, int kernelLength, int partitionSize)
+{
+    jassert(juce::isPowerOfTwo(kernelLength) && juce::isPowerOfTwo(partitionSize));
+    jassert(partitionSize <= kernelLength);
+
+    const int numBins = kernelLength / 2 + 1;
+
+    // Total magnitude in dB on the FFT grid, from the exact biquad responses
+    std::vector<float> phi(static_cast<size_t>(numBins));
+    std::vector<float> totalDb(static_cast<size_t>(numBins), 0.0f);
+    std::vector<float> bandDb(static_cast<size_t>(numBins));
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        const auto halfW = juce::MathConstants<double>::pi * k / kernelLength;
+        phi[static_cast<size_t>(k)] = static_cast<float>(std::sin(halfW) * std::sin(halfW));
+    }
+
+    for (const auto& band : bands)
+    {
+        if (BiquadDesign::isUnity(band))
+            continue;
+
+        BiquadDesign::Coefficients coefficients;
+        BiquadDesign::design(band, sampleRate, coefficients);
+        BiquadDesign::getMagnitudeResponseDb(coefficients, phi.data(), bandDb.data(), numBins);
+        juce::FloatVectorOperations::add(totalDb.data(), bandDb.data(), numBins);
+    }
+
+    // A real, zero-phase spectrum transforms to an impulse response that is
+    // symmetric around sample 0; rotating it by half the length centres it
+    juce::dsp::FFT kernelFFT(juce::roundToInt(std::log2(kernelLength)));
+    std::vector<float> spectrum(static_cast<size_t>(kernelLength * 2), 0.0f);
+
+    for (int k = 0; k < numBins; ++k)
+        spectrum[static_cast<size_t>(2 * k)] = juce::Decibels::decibelsToGain(totalDb[static_cast<size_t>(k)], -300.0f);
+
+    kernelFFT.performRealOnlyInverseTransform(spectrum.data());
+
+    // Blackman taper, symmetric around the centre tap, against truncation ripple
+    std::vector<float> window(static_cast<size_t>(kernelLength + 1));
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                             juce::dsp::WindowingFunction<float>::blackman, false);
+
+    std::vector<float> impulse(static_cast<size_t>(kernelLength));
+    const int half = kernelLength / 2;
+
+    for (int n = 0; n < kernelLength; ++n)
+        impulse[static_cast<size_t>(n)] = spectrum[static_cast<size_t>((n + half) % kernelLength)] * window[static_cast<size_t>(n)];
+
+    // Cut into partitions, each zero-padded to twice its length and transformed
+    auto kernel = std::make_unique<LinearPhaseKernel>();
+    kernel->partitionSize = partitionSize;
+    kernel->numPartitions = kernelLength / partitionSize;
+
+    const int partitionBins = partitionSize + 1;
+    kernel->real.resize(static_cast<size_t>(kernel->numPartitions * partitionBins));
+    kernel->imag.resize(kernel->real.size());
+
+    juce::dsp::FFT partitionFFT(juce::roundToInt(std::log2(partitionSize * 2)));
+    std::vector<float> buffer(static_cast<size_t>(partitionSize * 4));
+
+    for (int partition = 0; partition < kernel->numPartitions; ++partition)
+    {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+        std::copy(impulse.begin() + partition * partitionSize,
+                  impulse.begin() + (partition + 1) * partitionSize,
+                  buffer.begin());
+
+        partitionFFT.performRealOnlyForwardTransform(buffer.data(), true);
+
+        auto* real = kernel->real.data() + partition * partitionBins;
+        auto* imag = kernel->imag.data() + partition * partitionBins;
+
+        for (int bin = 0; bin < partitionBins; ++bin)
+        {
+            real[bin] = buffer[static_cast<size_t>(2 * bin)];
+            imag[bin] = buffer[static_cast<size_t>(2 * bin + 1)];
+        }
+    }
+
+    return kernel;
+}
+
+} // namespace LinearPhaseDesign
+
+//==============================================================================
+PartitionedConvolver::~PartitionedConvolver()
+{
+    collectGarbage();
+    delete pendingKernel.exchange(nullptr);
+    delete currentKernel;
+    delete fadingKernel;
+    delete kernelToRetire;
+}
+
+void PartitionedConvolver::prepare(int newNumChannels, int newPartitionSize, int maxKernelLength)
+{
+    jassert(juce::isPowerOfTwo(newPartitionSize));
+
+    numChannels = newNumChannels;
+    partitionSize = newPartitionSize;
+    numBins = partitionSize + 1;
+    maxPartitions = (maxKernelLength + partitionSize - 1) / partitionSize;
+
+    fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(partitionSize * 2)));
+
+    const auto frameSize = static_cast<size_t>(partitionSize * 2);
+    const auto delaySize = static_cast<size_t>(maxPartitions * numBins);
+    inputFrames.assign(static_cast<size_t>(numChannels), std::vector<float>(frameSize, 0.0f));
+    outputBlocks.assign(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(partitionSize), 0.0f));
+    delayReal.assign(static_cast<size_t>(numChannels), std::vector<float>(delaySize, 0.0f));
+    delayImag.assign(static_cast<size_t>(numChannels), std::vector<float>(delaySize, 0.0f));
+
+    fftBuffer.assign(static_cast<size_t>(partitionSize * 4), 0.0f);
+    accumulatorReal.assign(static_cast<size_t>(numBins), 0.0f);
+    accumulatorImag.assign(static_cast<size_t>(numBins), 0.0f);
+    fadeBuffer.assign(static_cast<size_t>(partitionSize), 0.0f);
+
+    // Kernels were cut for the old partition size and length, so none is
+    // kept; one that outlived a drop in sample rate would have more
+    // partitions than the delay line now holds
+    delete pendingKernel.exchange(nullptr);
+    delete fadingKernel;
+    delete currentKernel;
+    fadingKernel = nullptr;
+    currentKernel = nullptr;
+
+    reset();
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    for (auto* channels : { &inputFrames, &outputBlocks, &delayReal, &delayImag })
+        for (auto& channel : *channels)
+            std::fill(channel.begin(), channel.end(), 0.0f);
+
+    fillPosition = 0;
+    head = 0;
+}
+
+void PartitionedConvolver::submitKernel(std::unique_ptr<LinearPhaseKernel> kernel)
+{
+    // A kernel the audio thread never picked up is simply replaced
+    delete pendingKernel.exchange(kernel.release());
+    collectGarbage();
+}
+
+void PartitionedConvolver::collectGarbage()
+{
+    delete retiredKernel.exchange(nullptr);
+}
+
+void PartitionedConvolver::retire(LinearPhaseKernel* kernel) noexcept
+{
+    jassert(kernelToRetire == nullptr);
+    kernelToRetire = kernel;
+
+    LinearPhaseKernel* expected = nullptr;
+    if (retiredKernel.compare_exchange_strong(expected, kernelToRetire))
+        kernelToRetire = nullptr;
+}
+
+void PartitionedConvolver::process(float* const* channels, int channelCount, int numSamples) noexcept
+{
+    const auto activeChannels = juce::jmin(channelCount, numChannels);
+    int position = 0;
+
+    while (position < numSamples)
+    {
+        // Feed the current input block and play out the previous result
+        const auto count = juce::jmin(partitionSize - fillPosition, numSamples - position);
+
+        for (int channel = 0; channel < activeChannels; ++channel)
+        {
+            auto* data = channels[channel] + position;
+            auto& frame = inputFrames[static_cast<size_t>(channel)];
+            auto& output = outputBlocks[static_cast<size_t>(channel)];
+
+            std::copy(data, data + count, frame.begin() + partitionSize + fillPosition);
+            std::copy(output.begin() + fillPosition, output.begin() + fillPosition + count, data);
+        }
+
+        fillPosition += count;
+        position += count;
+
+        if (fillPosition == partitionSize)
+        {
+            processPartition();
+            fillPosition = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processPartition() noexcept
+{
+    // A previously replaced kernel waits here until the other side has freed the last one
+    if (kernelToRetire != nullptr)
+    {
+        LinearPhaseKernel* expected = nullptr;
+        if (retiredKernel.compare_exchange_strong(expected, kernelToRetire))
+            kernelToRetire = nullptr;
+    }
+
+    // Only one fade at a time, and only once the last replaced kernel is gone
+    if (fadingKernel == nullptr && kernelToRetire == nullptr)
+    {
+        if (auto* incoming = pendingKernel.exchange(nullptr))
+        {
+            if (incoming->partitionSize != partitionSize || incoming->numPartitions > maxPartitions)
+            {
+                retire(incoming);
+            }
+            else
+            {
+                fadingKernel = currentKernel;
+                currentKernel = incoming;
+            }
+        }
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& frame = inputFrames[static_cast<size_t>(channel)];
+        auto* output = outputBlocks[static_cast<size_t>(channel)].data();
+
+        // Transform the last two input blocks into the head of the delay line
+        std::copy(frame.begin(), frame.end(), fftBuffer.begin());
+        std::fill(fftBuffer.begin() + partitionSize * 2, fftBuffer.end(), 0.0f);
+        fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+        auto* real = delayReal[static_cast<size_t>(channel)].data() + head * numBins;
+        auto* imag = delayImag[static_cast<size_t>(channel)].data() + head * numBins;
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            real[bin] = fftBuffer[static_cast<size_t>(2 * bin)];
+            imag[bin] = fftBuffer[static_cast<size_t>(2 * bin + 1)];
+        }
+
+        // Slide the input: the block just completed becomes the older half
+        std::copy(frame.begin() + partitionSize, frame.end(), frame.begin());
+
+        if (currentKernel == nullptr)
+        {
+            std::fill(output, output + partitionSize, 0.0f);
+            continue;
+        }
+
+        accumulate(*currentKernel, channel);
+        inverseTransform(output);
+
+        if (fadingKernel != nullptr)
+        {
+            accumulate(*fadingKernel, channel);
+            inverseTransform(fadeBuffer.data());
+
+            // Linear crossfade from the old kernel to the new one over this block
+            const auto step = 1.0f / static_cast<float>(partitionSize);
+
+            for (int i = 0; i < partitionSize; ++i)
+            {
+                const auto fadeIn = static_cast<float>(i) * step;
+                output[i] = fadeBuffer[static_cast<size_t>(i)] + fadeIn * (output[i] - fadeBuffer[static_cast<size_t>(i)]);
+            }
+        }
+    }
+
+    if (fadingKernel != nullptr)
+    {
+        retire(fadingKernel);
+        fadingKernel = nullptr;
+    }
+
+    head = (head + 1) % maxPartitions;
+}
+
+void PartitionedConvolver::accumulate(const LinearPhaseKernel& kernel, int channel) noexcept
+{
+    // Y = sum over p of X[n - p] * H[p], as split complex arrays so the
+    // inner loop vectorizes
+    auto* sumReal = accumulatorReal.data();
+    auto* sumImag = accumulatorImag.data();
+    std::fill(sumReal, sumReal + numBins, 0.0f);
+    std::fill(sumImag, sumImag + numBins, 0.0f);
+
+    const auto* inputReal = delayReal[static_cast<size_t>(channel)].data();
+    const auto* inputImag = delayImag[static_cast<size_t>(channel)].data();
+
+    for (int partition = 0; partition < kernel.numPartitions; ++partition)
+    {
+        const auto slot = (head - partition + maxPartitions) % maxPartitions;
+        const auto* xr = inputReal + slot * numBins;
+        const auto* xi = inputImag + slot * numBins;
+        const auto* hr = kernel.real.data() + partition * numBins;
+        const auto* hi = kernel.imag.data() + partition * numBins;
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            sumReal[bin] += xr[bin] * hr[bin] - xi[bin] * hi[bin];
+            sumImag[bin] += xr[bin] * hi[bin] + xi[bin] * hr[bin];
+        }
+    }
+}
+
+void PartitionedConvolver::inverseTransform(float* destination) noexcept
+{
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        fftBuffer[static_cast<size_t>(2 * bin)] = accumulatorReal[static_cast<size_t>(bin)];
+        fftBuffer[static_cast<size_t>(2 * bin + 1)] = accumulatorImag[static_cast<size_t>(bin)];
+    }
+
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    // Overlap-save: the first half wrapped around, the second half is valid
+    std::copy(fftBuffer.begin() + partitionSize, fftBuffer.begin() + partitionSize * 2, destination);
+}
+
+//==============================================================================
+LinearPhaseEQ::LinearPhaseEQ()
+    : juce::Thread("SondyEQ Linear Phase Design")
+{
+}
+
+LinearPhaseEQ::~LinearPhaseEQ()
+{
+    stopThread(2000);
+}
+
+int LinearPhaseEQ::getKernelLengthForSampleRate(double rate) noexcept
+{
+    return juce::jlimit(4096, 65536, juce::nextPowerOfTwo(juce::roundToInt(rate * 0.5)));
+}
+
+void LinearPhaseEQ::prepare(double newSampleRate, int numChannels, int newPartitionSize)
+{
+    // The design thread submits to the convolver, so it stops while that is rebuilt
+    stopThread(2000);
+
+    sampleRate = newSampleRate;
+    kernelLength = getKernelLengthForSampleRate(sampleRate);
+    partitionSize = juce::jlimit(64, kernelLength, juce::nextPowerOfTwo(newPartitionSize));
+
+    convolver.prepare(numChannels, partitionSize, kernelLength);
+    kernelDesigned = false;
+
+    {
+        const juce::ScopedLock lock(requestLock);
+        redesignRequested = false;
+    }
+
+    startThread();
+}
+
+void LinearPhaseEQ::designKernel(const std::vector<BiquadDesign::Parameters>& bands)
+{
+    // This kernel is newer than any request still waiting for the design thread
+    {
+        const juce::ScopedLock lock(requestLock);
+        redesignRequested = false;
+    }
+
+    convolver.submitKernel(LinearPhaseDesign::createKernel(bands, sampleRate, kernelLength, partitionSize));
+    kernelDesigned = true;
+}
+
+void LinearPhaseEQ::setBands(const std::vector<BiquadDesign::Parameters>& bands)
+{
+    {
+        const juce::ScopedLock lock(requestLock);
+        requestedBands = bands;
+        redesignRequested = true;
+    }
+
+    notify();
+}
+
+void LinearPhaseEQ::process(juce::AudioBuffer<float>& buffer) noexcept
+{
+    process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
+}
+
+void LinearPhaseEQ::process(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    convolver.process(channels, numChannels, numSamples);
+}
+
+void LinearPhaseEQ::run()
+{
+    std::vector<BiquadDesign::Parameters> bands;
+
+    while (!threadShouldExit())
+    {
+        convolver.collectGarbage();
+        bool requested;
+
+        {
+            const juce::ScopedLock lock(requestLock);
+            requested = redesignRequested;
+            redesignRequested = false;
+
+            if (requested)
+                bands = requestedBands;
+        }
+
+        // Edits that arrive while designing are folded into the next kernel
+        if (requested)
+        {
+            convolver.submitKernel(LinearPhaseDesign::createKernel(bands, sampleRate, kernelLength, partitionSize));
+            kernelDesigned = true;
+        }
+        else
+            wait(-1);
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "BiquadDesign.h"
+
+/** A linear-phase FIR kernel, already cut into partitions and transformed into
+    the frequency domain the way PartitionedConvolver consumes it. Each
+    partition holds partitionSize + 1 bins in split real/imaginary arrays,
+    laid out as [partition * (partitionSize + 1) + bin].
+*/
+struct LinearPhaseKernel
+{
+    int partitionSize = 0;
+    int numPartitions = 0;
+    std::vector<float> real, imag;
+};
+
+namespace LinearPhaseDesign
+{
+    /** Builds a symmetric kernelLength-tap FIR whose magnitude is the product of
+        the bands' responses (the same data as the editor's response curve),
+        with a pure delay of kernelLength / 2 samples. Not realtime safe.
+    */
+    std::unique_ptr<LinearPhaseKernel> createKernel(const std::vector<BiquadDesign::Parameters>& bands,
+                                                    double sampleRate, int kernelLength, int partitionSize);
+}
+
+/** Uniformly partitioned overlap-save convolution with a frequency-domain delay line.
+
+    Input is collected in blocks of partitionSize samples. Each full block is
+    transformed once and pushed into the delay line; the output block is the
+    sum of every stored input spectrum times its kernel partition, so the cost
+    per block is constant however long the kernel is, and the latency is one
+    partition.
+
+    New kernels are handed over lock-free and crossfaded in over one
+    partition. The input spectra don't depend on the kernel, so the fade only
+    costs one extra accumulation. The audio thread never allocates or frees a
+    kernel; replaced ones are passed back for the submitting thread to delete.
+*/
+class PartitionedConvolver
+{
+public:
+    PartitionedConvolver() = default;
+    ~PartitionedConvolver();
+
+    /** Allocates everything for kernels of up to maxKernelLength taps. Not realtime safe. */
+    void prepare(int numChannels, int partitionSize, int maxKernelLength);
+    void reset() noexcept;
+
+    int getPartitionSize() const noexcept { return partitionSize; }
+
+    /** Any thread but the audio thread: queues a kernel to be faded in. */
+    void submitKernel(std::unique_ptr<LinearPhaseKernel> kernel);
+
+    /** Any thread but the audio thread: frees kernels the audio thread has let go of. */
+    void collectGarbage();
+
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    int numChannels = 0;
+    int partitionSize = 0;
+    int numBins = 0;
+    int maxPartitions = 0;
+    int fillPosition = 0;
+    int head = 0;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+
+    // Per channel: the last two input blocks, the output block being played
+    // and the frequency-domain delay line, [slot * numBins + bin]
+    std::vector<std::vector<float>> inputFrames, outputBlocks, delayReal, delayImag;
+    std::vector<float> fftBuffer, accumulatorReal, accumulatorImag, fadeBuffer;
+
+    LinearPhaseKernel* currentKernel = nullptr;
+    LinearPhaseKernel* fadingKernel = nullptr;
+    LinearPhaseKernel* kernelToRetire = nullptr;
+    std::atomic<LinearPhaseKernel*> pendingKernel { nullptr };
+    std::atomic<LinearPhaseKernel*> retiredKernel { nullptr };
+
+    void processPartition() noexcept;
+    void accumulate(const LinearPhaseKernel& kernel, int channel) noexcept;
+    void inverseTransform(float* destination) noexcept;
+    void retire(LinearPhaseKernel* kernel) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE(PartitionedConvolver)
+};
+
+/** Linear-phase processing of the whole band chain.
+
+    Band edits are designed into a new kernel on a background thread and
+    handed to the convolver, so the audio thread only ever convolves. The
+    total latency is one partition plus half the kernel.
+*/
+class LinearPhaseEQ : private juce::Thread
+{
+public:
+    LinearPhaseEQ();
+    ~LinearPhaseEQ() override;
+
+    /** Allocates the convolver, dropping any kernel it had. No kernel is
+        designed: until designKernel() the output is silent. Not realtime safe.
+    */
+    void prepare(double sampleRate, int numChannels, int partitionSize);
+
+    /** Designs a kernel synchronously and hands it to the convolver, for
+        when one is needed before the next block. Not realtime safe.
+    */
+    void designKernel(const std::vector<BiquadDesign::Parameters>& bands);
+
+    /** True once a kernel has been designed since prepare(). */
+    bool hasKernel() const noexcept { return kernelDesigned.load(); }
+
+    /** Message thread: queues a redesign for a new set of bands. */
+    void setBands(const std::vector<BiquadDesign::Parameters>& bands);
+
+    /** Kernel length for a sample rate: about half a second, as a power of two,
+        which gives 32768 taps at 44.1/48 kHz and 65536 at 96 kHz.
+    */
+    static int getKernelLengthForSampleRate(double sampleRate) noexcept;
+
+    int getKernelLength() const noexcept { return kernelLength; }
+    int getPartitionSize() const noexcept { return partitionSize; }
+    int getLatencySamples() const noexcept { return partitionSize + kernelLength / 2; }
+
+    void process(juce::AudioBuffer<float>& buffer) noexcept;
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    void run() override;
+
+    PartitionedConvolver convolver;
+    double sampleRate = 44100.0;
+    int kernelLength = 0;
+    int partitionSize = 0;
+
+    juce::CriticalSection requestLock;
+    std::vector<BiquadDesign::Parameters> requestedBands;
+    bool redesignRequested = false;
+    std::atomic<bool> kernelDesigned { false };
+
+    JUCE_DECLARE_NON_COPYABLE(LinearPhaseEQ)
+};
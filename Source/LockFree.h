@@ -0,0 +1,163 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+/** Wait-free single-producer/single-consumer ring of planar audio.
+
+    The producer (audio thread) copies whole blocks in with at most two
+    memcpys per channel; if the consumer falls behind, whatever doesn't fit
+    is dropped rather than waiting. Storage is allocated once up front, so
+    neither side ever allocates.
+*/
+class SpscAudioRing
+{
+public:
+    /** capacity is rounded up to a power of two. */
+    SpscAudioRing(int numChannels, int capacity)
+        : capacity(juce::nextPowerOfTwo(capacity))
+        , mask(this->capacity - 1)
+        , storage(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(this->capacity), 0.0f))
+    {
+    }
+
+    int getNumChannels() const noexcept { return static_cast<int>(storage.size()); }
+    int getCapacity() const noexcept { return capacity; }
+
+    /** Producer: appends the block; a mono source feeds every ring channel.
+        Double-precision blocks are rounded to float on the way in.
+    */
+    template <typename SampleType>
+    void push(const juce::AudioBuffer<SampleType>& buffer) noexcept
+    {
+        if (buffer.getNumChannels() == 0)
+            return;
+
+        const auto write = writePosition.load(std::memory_order_relaxed);
+        const auto read = readPosition.load(std::memory_order_acquire);
+        const auto space = capacity - static_cast<int>(write - read);
+        const auto numSamples = juce::jmin(buffer.getNumSamples(), space);
+
+        if (numSamples <= 0)
+            return;
+
+        const auto start = static_cast<int>(write & static_cast<juce::uint32>(mask));
+        const auto firstPart = juce::jmin(numSamples, capacity - start);
+
+        for (size_t ch = 0; ch < storage.size(); ++ch)
+        {
+            const auto* source = buffer.getReadPointer(juce::jmin(static_cast<int>(ch), buffer.getNumChannels() - 1));
+            auto* dest = storage[ch].data();
+
+            copyIn(dest + start, source, firstPart);
+            copyIn(dest, source + firstPart, numSamples - firstPart);
+        }
+
+        writePosition.store(write + static_cast<juce::uint32>(numSamples), std::memory_order_release);
+    }
+
+    /** Consumer: copies up to maxSamples into dest and returns how many were read. */
+    int pop(float* const* dest, int numDestChannels, int maxSamples) noexcept
+    {
+        const auto read = readPosition.load(std::memory_order_relaxed);
+        const auto write = writePosition.load(std::memory_order_acquire);
+        const auto numSamples = juce::jmin(maxSamples, static_cast<int>(write - read));
+
+        if (numSamples <= 0)
+            return 0;
+
+        const auto start = static_cast<int>(read & static_cast<juce::uint32>(mask));
+        const auto firstPart = juce::jmin(numSamples, capacity - start);
+        const auto channels = juce::jmin(numDestChannels, getNumChannels());
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            const auto* source = storage[static_cast<size_t>(ch)].data();
+
+            juce::FloatVectorOperations::copy(dest[ch], source + start, firstPart);
+            juce::FloatVectorOperations::copy(dest[ch] + firstPart, source, numSamples - firstPart);
+        }
+
+        readPosition.store(read + static_cast<juce::uint32>(numSamples), std::memory_order_release);
+        return numSamples;
+    }
+
+private:
+    const int capacity;
+    const int mask;
+    std::vector<std::vector<float>> storage;
+
+    static void copyIn(float* dest, const float* source, int numSamples) noexcept
+    {
+        juce::FloatVectorOperations::copy(dest, source, numSamples);
+    }
+
+    static void copyIn(float* dest, const double* source, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = static_cast<float>(source[i]);
+    }
+
+    // Free-running counters; their difference is the fill level
+    std::atomic<juce::uint32> writePosition { 0 }, readPosition { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(SpscAudioRing)
+};
+
+/** Lock-free triple buffer for handing finished frames from one thread to another.
+
+    The writer fills getWriteBuffer() and publishes it; the reader calls fetch()
+    and then reads getReadBuffer(). Neither side ever waits, and the reader
+    always sees the newest complete frame.
+*/
+template <typename FrameType>
+class TripleBuffer
+{
+public:
+    explicit TripleBuffer(const FrameType& prototype = {})
+        : buffers { prototype, prototype, prototype }
+    {
+    }
+
+    // Writer side
+    FrameType& getWriteBuffer() noexcept { return buffers[static_cast<size_t>(backIndex)]; }
+
+    void publish() noexcept
+    {
+        const auto previous = middle.exchange(backIndex | freshFlag, std::memory_order_acq_rel);
+        backIndex = previous & indexMask;
+    }
+
+    // Reader side: returns true if a newer frame was swapped in
+    bool fetch() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshFlag) == 0)
+            return false;
+
+        const auto previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & indexMask;
+        return true;
+    }
+
+    // Reader side: true if a frame has been published since the last fetch
+    bool hasNewFrame() const noexcept
+    {
+        return (middle.load(std::memory_order_relaxed) & freshFlag) != 0;
+    }
+
+    const FrameType& getReadBuffer() const noexcept { return buffers[static_cast<size_t>(frontIndex)]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<FrameType, 3> buffers;
+    int backIndex = 0;
+    int frontIndex = 1;
+    std::atomic<int> middle { 2 };
+
+    JUCE_DECLARE_NON_COPYABLE(TripleBuffer)
+};
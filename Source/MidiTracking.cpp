@@ -0,0 +1,118 @@
+#include "MidiTracking.h"
+#include <algorithm>
+#include <cmath>
+
+void MidiTracker::reset() noexcept
+{
+    numHeldNotes = 0;
+    note = -1;
+    velocity = 1.0f;
+    controllers.fill(-1.0f);
+}
+
+bool MidiTracker::handleEvent(const juce::uint8* data, int numBytes) noexcept
+{
+    if (numBytes < 3)
+        return false;
+
+    // Every channel counts; a resonance doesn't care which one played the note
+    const auto status = data[0] & 0xf0;
+    const auto number = data[1] & 0x7f;
+    const auto value = data[2] & 0x7f;
+
+    switch (status)
+    {
+        case 0x90:
+            if (value > 0)
+            {
+                startNote(number, static_cast<float>(value) / 127.0f);
+                return true;
+            }
+
+            return stopNote(number);   // note-on at velocity 0 is a note-off
+
+        case 0x80:
+            return stopNote(number);
+
+        case 0xb0:
+        {
+            const auto newValue = static_cast<float>(value) / 127.0f;
+            const auto changed = controllers[static_cast<size_t>(number)] != newValue;
+            controllers[static_cast<size_t>(number)] = newValue;
+            return changed;
+        }
+
+        default:
+            return false;
+    }
+}
+
+void MidiTracker::startNote(int newNote, float newVelocity) noexcept
+{
+    stopNote(newNote);
+
+    if (numHeldNotes == maxHeldNotes)
+    {
+        std::move(heldNotes.begin() + 1, heldNotes.end(), heldNotes.begin());
+        --numHeldNotes;
+    }
+
+    heldNotes[static_cast<size_t>(numHeldNotes++)] = { newNote, newVelocity };
+    note = newNote;
+    velocity = newVelocity;
+}
+
+bool MidiTracker::stopNote(int oldNote) noexcept
+{
+    const auto end = heldNotes.begin() + numHeldNotes;
+    const auto held = std::find_if(heldNotes.begin(), end, [oldNote](const HeldNote& h) { return h.note == oldNote; });
+
+    if (held == end)
+        return false;
+
+    std::move(held + 1, end, held);
+    --numHeldNotes;
+
+    // Back to the most recent note still held; the last one released stays
+    if (numHeldNotes == 0)
+        return false;
+
+    const auto& latest = heldNotes[static_cast<size_t>(numHeldNotes - 1)];
+    const auto changed = latest.note != note || latest.velocity != velocity;
+    note = latest.note;
+    velocity = latest.velocity;
+    return changed;
+}
+
+BiquadDesign::Parameters MidiTracker::apply(const BiquadDesign::Parameters& parameters,
+                                            const BandTracking& tracking) const noexcept
+{
+    auto result = parameters;
+
+    if (tracking.harmonic > 0 && note >= 0)
+        result.frequency = static_cast<float>(tracking.harmonic) * 440.0f
+                             * std::exp2(static_cast<float>(note - 69) / 12.0f);
+
+    switch (tracking.gainSource)
+    {
+        case BandTracking::GainSource::velocity:
+            if (note >= 0)
+                result.gain *= velocity;
+            break;
+
+        case BandTracking::GainSource::controller:
+        {
+            const auto value = controllers[static_cast<size_t>(juce::jlimit(0, 127, tracking.controller))];
+
+            if (value >= 0.0f)
+                result.gain *= value;
+            break;
+        }
+
+        case BandTracking::GainSource::fixed:
+        default:
+            break;
+    }
+
+    return result;
+}
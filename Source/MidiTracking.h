@@ -0,0 +1,55 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include "EQBand.h"
+
+/** The notes and controllers tracked bands follow (see BandTracking), as
+    seen by the audio thread.
+
+    Notes use last-note priority: the band follows the most recent note
+    still held, and keeps the last pitch once every note is released, so a
+    resonance stays tamed through the release. Events are taken from raw
+    MIDI bytes, one at a time, so the caller can split a block at each
+    event's timestamp; nothing allocates.
+*/
+class MidiTracker
+{
+public:
+    MidiTracker() { reset(); }
+
+    /** Forgets every note and controller; bands go back to their own settings. */
+    void reset() noexcept;
+
+    /** Takes one MIDI event. Returns true if it changed anything a tracked
+        band follows, i.e. the bands need redesigning.
+    */
+    bool handleEvent(const juce::uint8* data, int numBytes) noexcept;
+
+    /** A band's parameters under the notes and controllers so far. */
+    BiquadDesign::Parameters apply(const BiquadDesign::Parameters& parameters,
+                                   const BandTracking& tracking) const noexcept;
+
+private:
+    static constexpr int maxHeldNotes = 16;
+
+    struct HeldNote
+    {
+        int note = 0;
+        float velocity = 1.0f;
+    };
+
+    // Oldest first; beyond maxHeldNotes the oldest is forgotten
+    std::array<HeldNote, maxHeldNotes> heldNotes {};
+    int numHeldNotes = 0;
+
+    // The note bands follow, -1 before the first
+    int note = -1;
+    float velocity = 1.0f;
+
+    // 0 to 1, or -1 before the controller's first value
+    std::array<float, 128> controllers {};
+
+    void startNote(int newNote, float newVelocity) noexcept;
+    bool stopNote(int oldNote) noexcept;
+};
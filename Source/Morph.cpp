@@ -0,0 +1,63 @@
+#include "Morph.h"
+#include "BandChain.h"
+
+namespace
+{
+    /** The band's settings with as little effect as its type allows. */
+    BiquadDesign::Parameters getFlatParameters(BiquadDesign::Parameters parameters) noexcept
+    {
+        switch (parameters.type)
+        {
+            case FilterType::HighPass:  parameters.frequency = 2.0f; break;       // the lowest a design goes
+            case FilterType::LowPass:   parameters.frequency = 1.0e5f; break;     // designed just below Nyquist
+            case FilterType::Notch:     parameters.q = 100.0f; break;
+            case FilterType::Peak:
+            case FilterType::LowShelf:
+            case FilterType::HighShelf:
+            default:                    parameters.gain = 0.0f; break;
+        }
+
+        return parameters;
+    }
+
+    bool canMorph(const PluginState::Band& from, const PluginState::Band& to) noexcept
+    {
+        return from.parameters.type == to.parameters.type
+            && from.target == to.target
+            && from.dynamics.enabled == to.dynamics.enabled;
+    }
+}
+
+std::vector<MorphBand> pairSnapshotBands(const std::vector<PluginState::Band>& from,
+                                         const std::vector<PluginState::Band>& to)
+{
+    std::vector<MorphBand> bands;
+    bands.reserve(static_cast<size_t>(BandChain::maxBands));
+
+    const auto add = [&bands](const BiquadDesign::Parameters& start, const BiquadDesign::Parameters& end,
+                              const PluginState::Band& settings)
+    {
+        if (bands.size() < static_cast<size_t>(BandChain::maxBands))
+            bands.push_back({ start, end, settings.target, settings.dynamics, settings.tracking });
+    };
+
+    for (size_t i = 0; i < juce::jmax(from.size(), to.size()); ++i)
+    {
+        const auto* start = i < from.size() ? &from[i] : nullptr;
+        const auto* end = i < to.size() ? &to[i] : nullptr;
+
+        if (start != nullptr && end != nullptr && canMorph(*start, *end))
+        {
+            add(start->parameters, end->parameters, *start);
+            continue;
+        }
+
+        if (start != nullptr)
+            add(start->parameters, getFlatParameters(start->parameters), *start);
+
+        if (end != nullptr)
+            add(getFlatParameters(end->parameters), end->parameters, *end);
+    }
+
+    return bands;
+}
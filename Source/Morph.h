@@ -0,0 +1,30 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+#include "PluginState.h"
+
+/** One band of a morph between two snapshots: its settings at either end,
+    plus the channels, dynamics and MIDI tracking it keeps throughout.
+*/
+struct MorphBand
+{
+    BiquadDesign::Parameters from;
+    BiquadDesign::Parameters to;
+    ChannelTarget target = ChannelTarget::Stereo;
+    BandDynamics dynamics;
+    BandTracking tracking;
+};
+
+/** Lines up the bands of two snapshots for morphing, by position in the
+    band list.
+
+    Bands in the same place with the same type, channels and dynamics morph
+    into each other. Any other band fades in or out instead, becoming two
+    bands that each run to a flat version of themselves: a peak or shelf at
+    0 dB, and for the types without a gain, a high-pass at the bottom of
+    the range, a low-pass at Nyquist or a notch too narrow to hear. The
+    result has at most BandChain::maxBands bands; message thread.
+*/
+std::vector<MorphBand> pairSnapshotBands(const std::vector<PluginState::Band>& from,
+                                         const std::vector<PluginState::Band>& to);
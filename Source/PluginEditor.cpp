@@ -44,9 +44,4 @@ void SondyEQAudioProcessorEditor::resized()
     // Make sure the interface fills the entire editor window
     eqInterface.setBounds(getLocalBounds());
 }
-
-void SondyEQAudioProcessorEditor::processBlock(juce::AudioBuffer<float>& buffer)
-{
-    // Pass the audio data to the interface for visualization
-    eqInterface.process(buffer);
-} 
\ No newline at end of file
+ 
\ No newline at end of file
@@ -1,11 +1,41 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    constexpr float minParameterFrequency = 10.0f;
+    constexpr float maxParameterFrequency = 30000.0f;
+    constexpr float maxParameterGain = 30.0f;
+    constexpr float minParameterQ = 0.1f;
+    constexpr float maxParameterQ = 100.0f;
+    constexpr int numFilterTypes = static_cast<int>(FilterType::HighPass) + 1;
+    
+    // Normalised changes smaller than this are parameter rounding, not edits
+    constexpr float syncTolerance = 1.0e-6f;
+}
+
 SondyEQAudioProcessor::SondyEQAudioProcessor()
     : AudioProcessor (BusesProperties()
                      .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                     .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                      .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
+    , valueTreeState (*this, nullptr, "Parameters", createParameterLayout())
 {
+    for (int slot = 0; slot < BandChain::maxBands; ++slot)
+    {
+        for (int index = 0; index < numSlotParameters; ++index)
+        {
+            const auto id = getParameterId(slot, static_cast<SlotParameter>(index));
+            auto* parameter = valueTreeState.getParameter(id);
+            slotParameters[static_cast<size_t>(slot)][static_cast<size_t>(index)] = parameter;
+            slotValues[static_cast<size_t>(slot)][static_cast<size_t>(index)] = valueTreeState.getRawParameterValue(id);
+            syncedValues[static_cast<size_t>(slot)][static_cast<size_t>(index)] = parameter->getValue();
+        }
+    }
+    
+    // The audio thread builds its chain in place
+    automatedChain.bands.reserve(static_cast<size_t>(BandChain::maxBands));
+    
     // Initialize with some default bands
     auto lowShelf = std::make_unique<EQBand>();
     lowShelf->setFrequency(100.0f);
@@ -24,10 +54,57 @@ SondyEQAudioProcessor::SondyEQAudioProcessor()
     highShelf->setType(FilterType::HighShelf);
     highShelf->setGain(0.0f);  // Initialize gain
     bands.push_back(std::move(highShelf));
+    
+    updateBandChain();
+    
+    // The bands belong to the message thread, so the sync runs there
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        startTimerHz(syncRateHz);
 }
 
 SondyEQAudioProcessor::~SondyEQAudioProcessor()
 {
+    stopTimer();
+    cancelPendingUpdate();
+}
+
+juce::String SondyEQAudioProcessor::getParameterId(int slot, SlotParameter parameter)
+{
+    static const char* const names[] = { "Enabled", "Type", "Frequency", "Gain", "Q" };
+    return "band" + juce::String(slot + 1) + names[parameter];
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout SondyEQAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    // Listed in the order of FilterType
+    const juce::StringArray typeNames { "Low Shelf", "High Shelf", "Peak", "Notch", "Low Pass", "High Pass" };
+    
+    juce::NormalisableRange<float> frequencyRange(minParameterFrequency, maxParameterFrequency);
+    frequencyRange.setSkewForCentre(1000.0f);
+    juce::NormalisableRange<float> gainRange(-maxParameterGain, maxParameterGain);
+    juce::NormalisableRange<float> qRange(minParameterQ, maxParameterQ);
+    qRange.setSkewForCentre(1.0f);
+    
+    for (int slot = 0; slot < BandChain::maxBands; ++slot)
+    {
+        const auto name = "Band " + juce::String(slot + 1) + " ";
+        
+        layout.add(std::make_unique<juce::AudioParameterBool>(
+            juce::ParameterID { getParameterId(slot, slotEnabled), 1 }, name + "On", false));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID { getParameterId(slot, slotType), 1 }, name + "Type", typeNames,
+            static_cast<int>(FilterType::Peak)));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID { getParameterId(slot, slotFrequency), 1 }, name + "Frequency", frequencyRange, 1000.0f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID { getParameterId(slot, slotGain), 1 }, name + "Gain", gainRange, 0.0f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID { getParameterId(slot, slotQ), 1 }, name + "Q", qRange, 1.0f));
+    }
+    
+    return layout;
 }
 
 const juce::String SondyEQAudioProcessor::getName() const
@@ -52,7 +129,7 @@ bool SondyEQAudioProcessor::isMidiEffect() const
 
 double SondyEQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int SondyEQAudioProcessor::getNumPrograms()
@@ -80,8 +157,14 @@ void SondyEQAudioProcessor::changeProgramName (int index, const juce::String& ne
 
 void SondyEQAudioProcessor::addBand(std::unique_ptr<EQBand> band)
 {
-    band->prepare(spec);
+    if (bands.size() >= static_cast<size_t>(BandChain::maxBands))
+        return;
+    
+    if (spec.sampleRate > 0.0)
+        band->setSampleRate(spec.sampleRate);
+    
     bands.push_back(std::move(band));
+    updateBandChain();
 }
 
 void SondyEQAudioProcessor::removeBand(EQBand* band)
@@ -89,6 +172,540 @@ void SondyEQAudioProcessor::removeBand(EQBand* band)
     bands.erase(std::remove_if(bands.begin(), bands.end(),
                               [band](const auto& b) { return b.get() == band; }),
                 bands.end());
+    updateBandChain();
+}
+
+void SondyEQAudioProcessor::updateBandChain()
+{
+    auto chain = std::make_unique<BandChain>();
+    chain->bands.reserve(bands.size());
+    
+    // The cascade's tail is the sum of its sections' ring-out times, each
+    // taken as the time for the slowest pole to decay by 100 dB
+    double tailSamples = 0.0;
+    
+    // An edit that moved a band off the morph ends it, right where it is
+    if (!morphBands.empty() && !bandsFollowMorph())
+        morphBands.clear();
+    
+    // New bands take the lowest free parameter slot
+    std::array<bool, BandChain::maxBands> slotIsTaken {};
+    
+    for (const auto& band : bands)
+        if (band->getSlot() >= 0)
+            slotIsTaken[static_cast<size_t>(band->getSlot())] = true;
+    
+    for (auto& band : bands)
+    {
+        if (band->getSlot() >= 0)
+            continue;
+        
+        const auto freeSlot = std::find(slotIsTaken.begin(), slotIsTaken.end(), false);
+        
+        if (freeSlot != slotIsTaken.end())
+        {
+            *freeSlot = true;
+            band->setSlot(static_cast<int>(std::distance(slotIsTaken.begin(), freeSlot)));
+        }
+    }
+    
+    // A band kept for a slot that is now taken again is gone for good
+    for (size_t slot = 0; slot < slotIsTaken.size(); ++slot)
+        if (slotIsTaken[slot])
+            disabledSlotIsStored[slot] = false;
+    
+    // Before publishing: the audio thread takes slotted bands' settings from the parameters
+    pushBandsToParameters();
+    
+    for (size_t i = 0; i < bands.size(); ++i)
+    {
+        const auto& band = bands[i];
+        chain->bands.push_back({ band->getId(), band->getParameters(), band->getChannelTarget(), band->getDynamics(), band->getTracking() });
+        chain->bands.back().slot = band->getSlot();
+        
+        if (!morphBands.empty())
+        {
+            // Morphing bands carry both ends; channels, dynamics and tracking stay editable
+            auto& morphBand = morphBands[i];
+            morphBand.target = band->getChannelTarget();
+            morphBand.dynamics = band->getDynamics();
+            morphBand.tracking = band->getTracking();
+            
+            auto& chainBand = chain->bands.back();
+            chainBand.parameters = morphBand.from;
+            chainBand.morphs = true;
+            chainBand.morphTarget = morphBand.to;
+        }
+        
+        if (!BiquadDesign::isUnity(band->getParameters()) || band->getDynamics().enabled)
+            tailSamples += BiquadDesign::getDecaySamples(band->getCoefficients(), 100.0);
+    }
+    
+    const auto rate = spec.sampleRate > 0.0 ? spec.sampleRate : 44100.0;
+    
+    // In linear-phase mode the tail beyond the reported latency is the kernel's second half
+    if (linearPhaseEnabled.load())
+    {
+        tailLengthSeconds = (linearPhase.getKernelLength() / 2) / rate;
+        
+        if (isPrepared)
+            linearPhase.setBands(getBandParameters());
+    }
+    else
+    {
+        tailLengthSeconds = juce::jmin(tailSamples / rate, maxTailLengthSeconds);
+    }
+    
+    bandChain.publish(std::move(chain));
+    saveBands();
+}
+
+void SondyEQAudioProcessor::pushBandsToParameters()
+{
+    std::array<const EQBand*, BandChain::maxBands> slotBands {};
+    
+    for (const auto& band : bands)
+        if (band->getSlot() >= 0)
+            slotBands[static_cast<size_t>(band->getSlot())] = band.get();
+    
+    for (int slot = 0; slot < BandChain::maxBands; ++slot)
+    {
+        // A slot without a band is off; its other values stay as the host left them
+        const auto* band = slotBands[static_cast<size_t>(slot)];
+        setSlotParameter(slot, slotEnabled, band != nullptr ? 1.0f : 0.0f);
+        
+        if (band == nullptr)
+            continue;
+        
+        setSlotParameter(slot, slotType, static_cast<float>(static_cast<int>(band->getType())));
+        setSlotParameter(slot, slotFrequency, band->getFrequency());
+        setSlotParameter(slot, slotGain, band->getGain());
+        setSlotParameter(slot, slotQ, band->getQ());
+    }
+}
+
+void SondyEQAudioProcessor::setSlotParameter(int slot, SlotParameter parameter, float value)
+{
+    auto* target = slotParameters[static_cast<size_t>(slot)][static_cast<size_t>(parameter)];
+    auto& synced = syncedValues[static_cast<size_t>(slot)][static_cast<size_t>(parameter)];
+    const auto normalised = target->convertTo0to1(value);
+    
+    if (std::abs(normalised - synced) > syncTolerance)
+    {
+        target->setValueNotifyingHost(normalised);
+        synced = target->getValue();
+    }
+}
+
+void SondyEQAudioProcessor::syncBandsWithParameters()
+{
+    std::array<EQBand*, BandChain::maxBands> slotBands {};
+    
+    for (const auto& band : bands)
+        if (band->getSlot() >= 0)
+            slotBands[static_cast<size_t>(band->getSlot())] = band.get();
+    
+    const auto rate = spec.sampleRate > 0.0 ? spec.sampleRate : 44100.0;
+    bool anyChanged = false;
+    bool anyRemoved = false;
+    
+    for (int slot = 0; slot < BandChain::maxBands; ++slot)
+    {
+        const auto& slotParameter = slotParameters[static_cast<size_t>(slot)];
+        auto& synced = syncedValues[static_cast<size_t>(slot)];
+        bool changed = false;
+        
+        for (size_t index = 0; index < slotParameter.size(); ++index)
+        {
+            const auto value = slotParameter[index]->getValue();
+            
+            if (std::abs(value - synced[index]) > syncTolerance)
+            {
+                synced[index] = value;
+                changed = true;
+            }
+        }
+        
+        if (!changed)
+            continue;
+        
+        anyChanged = true;
+        const auto& values = slotValues[static_cast<size_t>(slot)];
+        auto* band = slotBands[static_cast<size_t>(slot)];
+        
+        if (values[slotEnabled]->load() < 0.5f)
+        {
+            if (band != nullptr)
+            {
+                disabledSlotBands[static_cast<size_t>(slot)] = { band->getParameters(), band->getChannelTarget(),
+                                                                 band->getDynamics(), band->getTracking() };
+                disabledSlotIsStored[static_cast<size_t>(slot)] = true;
+                bands.erase(std::find_if(bands.begin(), bands.end(), [band](const auto& b) { return b.get() == band; }));
+                anyRemoved = true;
+            }
+            
+            continue;
+        }
+        
+        if (band == nullptr)
+        {
+            if (bands.size() >= static_cast<size_t>(BandChain::maxBands))
+                continue;
+            
+            bands.push_back(std::make_unique<EQBand>(rate));
+            band = bands.back().get();
+            band->setSlot(slot);
+            
+            // A band turned back on comes back with its channels, dynamics and tracking
+            if (disabledSlotIsStored[static_cast<size_t>(slot)])
+            {
+                const auto& stored = disabledSlotBands[static_cast<size_t>(slot)];
+                band->setChannelTarget(stored.target);
+                band->setDynamics(stored.dynamics);
+                band->setTracking(stored.tracking);
+                disabledSlotIsStored[static_cast<size_t>(slot)] = false;
+            }
+        }
+        
+        // One design for all five values, keeping channels and dynamics
+        BiquadDesign::Parameters parameters;
+        parameters.type = static_cast<FilterType>(juce::jlimit(0, numFilterTypes - 1, juce::roundToInt(values[slotType]->load())));
+        parameters.frequency = values[slotFrequency]->load();
+        parameters.gain = values[slotGain]->load();
+        parameters.q = values[slotQ]->load();
+        
+        BiquadDesign::Coefficients coefficients;
+        BiquadDesign::design(parameters, rate, coefficients);
+        band->restore(parameters, band->getChannelTarget(), band->getDynamics(), band->getTracking(), coefficients);
+    }
+    
+    if (!anyChanged)
+        return;
+    
+    if (anyRemoved)
+        ++bandListSerial;
+    
+    ++bandSettingsSerial;
+    updateBandChain();
+}
+
+void SondyEQAudioProcessor::timerCallback()
+{
+    syncBandsWithParameters();
+}
+
+void SondyEQAudioProcessor::beginParameterGesture(int slot)
+{
+    if (slot < 0 || slot >= BandChain::maxBands)
+        return;
+    
+    // The editor drags frequency and gain together
+    slotParameters[static_cast<size_t>(slot)][slotFrequency]->beginChangeGesture();
+    slotParameters[static_cast<size_t>(slot)][slotGain]->beginChangeGesture();
+}
+
+void SondyEQAudioProcessor::endParameterGesture(int slot)
+{
+    if (slot < 0 || slot >= BandChain::maxBands)
+        return;
+    
+    slotParameters[static_cast<size_t>(slot)][slotFrequency]->endChangeGesture();
+    slotParameters[static_cast<size_t>(slot)][slotGain]->endChangeGesture();
+}
+
+PluginState SondyEQAudioProcessor::getState() const
+{
+    PluginState state;
+    state.bands.reserve(bands.size());
+    
+    for (const auto& band : bands)
+        state.bands.push_back({ band->getParameters(), band->getChannelTarget(), band->getDynamics(), band->getTracking() });
+    
+    getSettings(state);
+    return state;
+}
+
+void SondyEQAudioProcessor::getSettings(PluginState& state) const
+{
+    state.oversamplingOrder = oversamplingOrder.load();
+    state.linearPhase = linearPhaseEnabled.load();
+    state.linearPhasePartitionSize = linearPhasePartitionSize.load();
+    state.topology = filterTopology.load();
+}
+
+void SondyEQAudioProcessor::saveBands()
+{
+    const juce::ScopedLock lock(savedStateLock);
+    
+    // Reuses the copy's storage, so only a growing band count allocates
+    savedBands.clear();
+    
+    for (const auto& band : bands)
+        savedBands.push_back({ band->getParameters(), band->getChannelTarget(), band->getDynamics(), band->getTracking() });
+}
+
+void SondyEQAudioProcessor::setState(const PluginState& state)
+{
+    morphBands.clear();
+    restoreBands(state.bands);
+    ++bandListSerial;
+    
+    // Bands kept for slots automated off belonged to the old state
+    disabledSlotIsStored.fill(false);
+    
+    // Settings go in directly rather than through their setters, which would
+    // each publish a chain or resend the bands to the kernel designer
+    oversamplingOrder = juce::jlimit(0, maxOversamplingOrder, state.oversamplingOrder);
+    filterTopology = state.topology;
+    
+    const auto partitionSize = juce::nextPowerOfTwo(juce::jlimit(256, 4096, state.linearPhasePartitionSize));
+    
+    // Only an actual change of partition size reallocates the convolver
+    if (partitionSize != linearPhasePartitionSize)
+        setLinearPhasePartitionSize(partitionSize);
+    
+    // The bands are restored by now, so the first kernel is the state's own
+    if (state.linearPhase)
+        designFirstKernel();
+    
+    linearPhaseEnabled = state.linearPhase;
+    updateLatency();
+    
+    updateBandChain();
+}
+
+void SondyEQAudioProcessor::restoreBands(const std::vector<PluginState::Band>& newBands)
+{
+    const auto numBands = juce::jmin(static_cast<int>(newBands.size()), BandChain::maxBands);
+    const auto rate = spec.sampleRate > 0.0 ? spec.sampleRate : 44100.0;
+    
+    // Every band's coefficients in one batch, instead of a redesign per setter
+    std::array<BiquadDesign::Parameters, BandChain::maxBands> parameters;
+    std::array<BiquadDesign::Coefficients, BandChain::maxBands> coefficients;
+    
+    for (int i = 0; i < numBands; ++i)
+        parameters[static_cast<size_t>(i)] = newBands[static_cast<size_t>(i)].parameters;
+    
+    BiquadDesign::designBatch(parameters.data(), coefficients.data(), numBands, rate);
+    
+    // Existing bands are overwritten in place (keeping their filter state in
+    // the cascade); only a change in the number of bands allocates or frees
+    if (bands.size() > static_cast<size_t>(numBands))
+        bands.resize(static_cast<size_t>(numBands));
+    
+    while (bands.size() < static_cast<size_t>(numBands))
+        bands.push_back(std::make_unique<EQBand>(rate));
+    
+    for (int i = 0; i < numBands; ++i)
+    {
+        const auto index = static_cast<size_t>(i);
+        bands[index]->restore(parameters[index], newBands[index].target, newBands[index].dynamics,
+                              newBands[index].tracking, coefficients[index]);
+    }
+}
+
+void SondyEQAudioProcessor::storeSnapshot(int slot)
+{
+    if (slot < 0 || slot >= numSnapshots)
+        return;
+    
+    snapshots[static_cast<size_t>(slot)] = getState().bands;
+    snapshotIsStored[static_cast<size_t>(slot)] = true;
+    
+    // The morph's end points just changed; keep what is playing now
+    if (!morphBands.empty())
+    {
+        morphBands.clear();
+        updateBandChain();
+    }
+}
+
+bool SondyEQAudioProcessor::hasSnapshot(int slot) const
+{
+    return slot >= 0 && slot < numSnapshots && snapshotIsStored[static_cast<size_t>(slot)];
+}
+
+void SondyEQAudioProcessor::recallSnapshot(int slot)
+{
+    // A glide along the morph to the snapshot's end; with only one
+    // snapshot stored there is nothing to morph between, so it loads directly
+    if (hasSnapshot(0) && hasSnapshot(1))
+    {
+        setMorphPosition(slot == 0 ? 0.0f : 1.0f);
+    }
+    else if (hasSnapshot(slot))
+    {
+        morphBands.clear();
+        restoreBands(snapshots[static_cast<size_t>(slot)]);
+        ++bandListSerial;
+        updateBandChain();
+    }
+}
+
+void SondyEQAudioProcessor::setMorphPosition(float newPosition)
+{
+    if (!hasSnapshot(0) || !hasSnapshot(1))
+        return;
+    
+    const bool starting = morphBands.empty();
+    
+    morphPosition = juce::jlimit(0.0f, 1.0f, newPosition);
+    
+    if (starting)
+    {
+        morphBands = pairSnapshotBands(snapshots[0], snapshots[1]);
+        
+        // If the bands are still one of the snapshots, e.g. right after
+        // storing it, the glide starts from there rather than jumping
+        const auto isPlaying = [current = getState().bands](const std::vector<PluginState::Band>& snapshot)
+        {
+            return std::equal(current.begin(), current.end(), snapshot.begin(), snapshot.end(),
+                              [](const PluginState::Band& a, const PluginState::Band& b)
+                              {
+                                  return a.parameters == b.parameters && a.target == b.target
+                                      && a.dynamics.enabled == b.dynamics.enabled;
+                              });
+        };
+        
+        morphStartPosition = isPlaying(snapshots[1]) ? 1.0f : isPlaying(snapshots[0]) ? 0.0f : morphPosition;
+    }
+    
+    morphTargetPosition = morphPosition;
+    
+    // The bands follow the morph, so the display shows where it is heading;
+    // only their coefficients are redesigned, in one batch
+    std::vector<PluginState::Band> current;
+    current.reserve(morphBands.size());
+    
+    for (const auto& band : morphBands)
+        current.push_back({ BiquadDesign::interpolate(band.from, band.to, morphPosition), band.target, band.dynamics, band.tracking });
+    
+    restoreBands(current);
+    
+    if (starting)
+    {
+        ++bandListSerial;
+        updateBandChain();
+        return;
+    }
+    
+    // Already morphing: the audio thread has the chain and only needs the
+    // new position, which it glides to
+    saveBands();
+    
+    if (linearPhaseEnabled.load() && isPrepared)
+        linearPhase.setBands(getBandParameters());
+}
+
+bool SondyEQAudioProcessor::bandsFollowMorph() const
+{
+    if (bands.size() != morphBands.size())
+        return false;
+    
+    for (size_t i = 0; i < bands.size(); ++i)
+        if (bands[i]->getParameters() != BiquadDesign::interpolate(morphBands[i].from, morphBands[i].to, morphPosition))
+            return false;
+    
+    return true;
+}
+
+std::vector<BiquadDesign::Parameters> SondyEQAudioProcessor::getBandParameters() const
+{
+    std::vector<BiquadDesign::Parameters> parameters;
+    parameters.reserve(bands.size());
+    
+    // The convolver runs one kernel on every channel, so bands aimed at
+    // part of the signal only take effect in minimum-phase mode
+    for (const auto& band : bands)
+        if (band->getChannelTarget() == ChannelTarget::Stereo)
+            parameters.push_back(band->getParameters());
+    
+    return parameters;
+}
+
+void SondyEQAudioProcessor::updateLatency()
+{
+    if (linearPhaseEnabled.load())
+        setLatencySamples(linearPhase.getLatencySamples());
+    else
+        setLatencySamples(oversamplingLatency[static_cast<size_t>(oversamplingOrder.load())]);
+}
+
+void SondyEQAudioProcessor::designFirstKernel()
+{
+    if (isPrepared && !linearPhase.hasKernel())
+        linearPhase.designKernel(getBandParameters());
+}
+
+void SondyEQAudioProcessor::setLinearPhaseEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled)
+        designFirstKernel();
+    
+    linearPhaseEnabled = shouldBeEnabled;
+    updateLatency();
+    
+    // Sends the current bands to the kernel designer
+    updateBandChain();
+}
+
+void SondyEQAudioProcessor::setLinearPhasePartitionSize(int newPartitionSize)
+{
+    linearPhasePartitionSize = newPartitionSize;
+    
+    if (isPrepared)
+    {
+        suspendProcessing(true);
+        linearPhase.prepare(spec.sampleRate, static_cast<int>(spec.numChannels), linearPhasePartitionSize);
+        
+        if (linearPhaseEnabled.load())
+            linearPhase.designKernel(getBandParameters());
+        
+        suspendProcessing(false);
+    }
+    
+    updateLatency();
+}
+
+template <typename SampleType>
+void SondyEQAudioProcessor::prepareEngine(Engine<SampleType>& engine, int samplesPerBlock)
+{
+    const auto numChannels = static_cast<int>(spec.numChannels);
+    
+    // Preallocate filter state for the largest possible chain
+    engine.cascade.prepare(spec.sampleRate, numChannels, samplesPerBlock);
+    engine.oversampledCascade.prepare(spec.sampleRate, numChannels, samplesPerBlock);
+    
+    // One thread per channel group at most, the audio thread included
+    const auto numWorkers = juce::jmin(engine.cascade.getNumGroups(), juce::SystemStats::getNumPhysicalCpus(),
+                                       maxWorkerThreads + 1) - 1;
+    
+    if (numWorkers <= 0)
+        workerPool = nullptr;
+    else if (workerPool == nullptr || workerPool->getNumWorkers() != numWorkers)
+        workerPool = std::make_unique<WorkerPool>(numWorkers);
+    
+    // Every factor is prepared up front so switching never allocates. The
+    // half-band polyphase IIR stages keep latency low, and integer latency
+    // lets a plain delay line stand in when the oversampler is skipped.
+    int maxLatency = 0;
+    
+    for (int order = 1; order <= maxOversamplingOrder; ++order)
+    {
+        auto& oversampler = engine.oversamplers[static_cast<size_t>(order - 1)];
+        oversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>(
+            spec.numChannels, static_cast<size_t>(order),
+            juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR, true, true);
+        oversampler->initProcessing(static_cast<size_t>(samplesPerBlock));
+        
+        oversamplingLatency[static_cast<size_t>(order)] = juce::roundToInt(oversampler->getLatencyInSamples());
+        maxLatency = juce::jmax(maxLatency, oversamplingLatency[static_cast<size_t>(order)]);
+    }
+    
+    engine.latencyDelay.setMaximumDelayInSamples(maxLatency + 1);
+    engine.latencyDelay.prepare(spec);
+    engine.dryBuffer.setSize(numChannels, samplesPerBlock);
+    engine.isPrepared = true;
 }
 
 void SondyEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
@@ -97,36 +714,235 @@ void SondyEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = samplesPerBlock;
     spec.numChannels = static_cast<size_t>(getTotalNumOutputChannels());
+    loadMonitor.prepare(sampleRate);
 
-    // Prepare each band
-    for (auto& band : bands)
+    // Every band redesigned for the new sample rate in one batch, as restoreBands() does
     {
-        band->prepare(spec);
-        band->setSampleRate(sampleRate);
+        const auto numBands = static_cast<int>(bands.size());
+        std::array<BiquadDesign::Parameters, BandChain::maxBands> parameters;
+        std::array<BiquadDesign::Coefficients, BandChain::maxBands> coefficients;
+        
+        for (int i = 0; i < numBands; ++i)
+            parameters[static_cast<size_t>(i)] = bands[static_cast<size_t>(i)]->getParameters();
+        
+        BiquadDesign::designBatch(parameters.data(), coefficients.data(), numBands, sampleRate);
+        
+        for (int i = 0; i < numBands; ++i)
+            bands[static_cast<size_t>(i)]->setSampleRate(sampleRate, coefficients[static_cast<size_t>(i)]);
+    }
+    
+    // Only the engine for the host's precision holds any state
+    const bool useDouble = isUsingDoublePrecision();
+    
+    if (useDouble)
+    {
+        prepareEngine(doubleEngine, samplesPerBlock);
+        floatEngine.isPrepared = false;
+    }
+    else
+    {
+        prepareEngine(floatEngine, samplesPerBlock);
+        doubleEngine.isPrepared = false;
+    }
+    
+    linearPhaseBuffer.setSize(useDouble ? static_cast<int>(spec.numChannels) : 0, samplesPerBlock);
+    dynamics.prepare(sampleRate, samplesPerBlock);
+    
+    // Notes and controllers held from the last playback don't carry over
+    midiTracker.reset();
+    
+    morphPositions.assign(static_cast<size_t>((samplesPerBlock + BiquadCascade<float>::tileSize - 1)
+                                                  / BiquadCascade<float>::tileSize), 0.0f);
+    smoothedMorphPosition = morphTargetPosition.load();
+    
+    activeOversamplingOrder = 0;
+    oversamplingEngaged = false;
+    previousBlockWasSilent = true;
+    
+    // A long kernel is costly to design, so an instance only designs one once
+    // linear phase is on: here if it already is, so the output is valid from
+    // the first block, and otherwise when it's switched on
+    linearPhase.prepare(sampleRate, static_cast<int>(spec.numChannels), linearPhasePartitionSize);
+    
+    if (linearPhaseEnabled.load())
+        linearPhase.designKernel(getBandParameters());
+    
+    silentInputSamples = 0;
+    
+    updateLatency();
+    isPrepared = true;
+    
+    updateBandChain();
+}
+
+void SondyEQAudioProcessor::setOversamplingOrder(int newOrder)
+{
+    newOrder = juce::jlimit(0, maxOversamplingOrder, newOrder);
+    oversamplingOrder = newOrder;
+    
+    // The latency is fixed per factor, whether or not any band engages the oversampler
+    updateLatency();
+}
+
+template <typename SampleType>
+void SondyEQAudioProcessor::setActiveOversamplingOrder(Engine<SampleType>& engine, int newOrder,
+                                                       const BandChain& chain) noexcept
+{
+    activeOversamplingOrder = newOrder;
+    oversamplingEngaged = false;
+    
+    if (newOrder > 0)
+    {
+        engine.oversamplers[static_cast<size_t>(newOrder - 1)]->reset();
+        engine.oversampledCascade.setSampleRate(spec.sampleRate * static_cast<double>(1 << newOrder));
+        engine.oversampledCascade.reset();
+        engine.latencyDelay.reset();
+        engine.latencyDelay.setDelay(static_cast<float>(oversamplingLatency[static_cast<size_t>(newOrder)]));
+    }
+    
+    routeBandChain(engine, chain);
+}
+
+template <typename SampleType>
+void SondyEQAudioProcessor::routeBandChain(Engine<SampleType>& engine, const BandChain& chain) noexcept
+{
+    // Bands at or above the split run behind the oversampler, designed at its
+    // rate. Dynamic bands stay at the base rate, where their gain is detected,
+    // and so do morphing bands, which move at its control rate.
+    const auto split = activeOversamplingOrder > 0
+                         ? static_cast<float>(spec.sampleRate * oversamplingThreshold)
+                         : std::numeric_limits<float>::max();
+    
+    // A chain that starts morphing picks up from what was playing
+    const auto morphing = std::any_of(chain.bands.begin(), chain.bands.end(),
+                                      [](const BandChain::Band& band) { return band.morphs; });
+    
+    if (morphing && !chainIsMorphing)
+        smoothedMorphPosition = morphStartPosition.load(std::memory_order_relaxed);
+    
+    chainIsMorphing = morphing;
+    const auto topology = filterTopology.load(std::memory_order_relaxed);
+    engine.cascade.setTopology(topology);
+    engine.oversampledCascade.setTopology(topology);
+    engine.cascade.setMorphPosition(smoothedMorphPosition);
+    engine.cascade.setChain(chain, 0.0f, split);
+    engine.oversampledCascade.setChain(chain, split, std::numeric_limits<float>::max(), false);
+    dynamics.setChain(chain);
+}
+
+template <typename SampleType>
+void SondyEQAudioProcessor::processOversamplingStage(Engine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer,
+                                                     int startSample, int numSamplesToProcess) noexcept
+{
+    auto& oversampler = *engine.oversamplers[static_cast<size_t>(activeOversamplingOrder - 1)];
+    const bool engage = engine.oversampledCascade.getNumSections() > 0;
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), static_cast<int>(spec.numChannels));
+    const auto maxBlockSize = static_cast<int>(spec.maximumBlockSize);
+    SampleType* channelPointers[maxChannels];
+    
+    // The oversampler is only prepared for maximumBlockSize samples at a time
+    const auto end = startSample + numSamplesToProcess;
+    
+    for (int start = startSample; start < end; start += maxBlockSize)
+    {
+        const auto numSamples = juce::jmin(maxBlockSize, end - start);
+        juce::dsp::AudioBlock<SampleType> block(buffer.getArrayOfWritePointers(), static_cast<size_t>(numChannels),
+                                           static_cast<size_t>(start), static_cast<size_t>(numSamples));
+        
+        if (!engage && !oversamplingEngaged)
+        {
+            // Nothing needs oversampling: only match the latency the host was told about
+            juce::dsp::ProcessContextReplacing<SampleType> context(block);
+            engine.latencyDelay.process(context);
+            continue;
+        }
+        
+        // The delayed dry path keeps running so either path can take over seamlessly
+        juce::dsp::AudioBlock<SampleType> dry(engine.dryBuffer.getArrayOfWritePointers(), static_cast<size_t>(numChannels),
+                                         0, static_cast<size_t>(numSamples));
+        dry.copyFrom(block);
+        juce::dsp::ProcessContextReplacing<SampleType> dryContext(dry);
+        engine.latencyDelay.process(dryContext);
+        
+        if (engage && !oversamplingEngaged)
+            oversampler.reset();
+        
+        auto upsampled = oversampler.processSamplesUp(block);
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+            channelPointers[channel] = upsampled.getChannelPointer(static_cast<size_t>(channel));
+        
+        engine.oversampledCascade.process(channelPointers, numChannels, static_cast<int>(upsampled.getNumSamples()));
+        oversampler.processSamplesDown(block);
+        
+        if (engage != oversamplingEngaged)
+        {
+            // Crossfade from the path that was running to the one taking over
+            const auto wetStart = engage ? SampleType(0) : SampleType(1);
+            
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                buffer.applyGainRamp(channel, start, numSamples, wetStart, SampleType(1) - wetStart);
+                buffer.addFromWithRamp(channel, start, engine.dryBuffer.getReadPointer(channel), numSamples,
+                                       SampleType(1) - wetStart, wetStart);
+            }
+            
+            oversamplingEngaged = engage;
+        }
     }
 }
 
 void SondyEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this to free up any spare memory, etc.
+    workerPool = nullptr;
 }
 
 bool SondyEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to wide immersive beds and higher-order Ambisonics;
+    // the cascade packs channels into SIMD lanes, so width costs little.
+    const auto& mainOutput = layouts.getMainOutputChannelSet();
+    if (mainOutput.isDisabled() || mainOutput.size() > maxChannels)
         return false;
 
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
 
+    // The sidechain only keys dynamic bands, so mono or stereo is enough
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet(true, 1).size() > 2)
+        return false;
+    
+    if (layouts.inputBuses.size() > 1 && !layouts.getChannelSet(true, 1).isDisabled()
+        && mainOutput.size() > maxChannelsWithSidechain)
+        return false;
+
     return true;
 }
 
 void SondyEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                         juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+void SondyEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                        juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+bool SondyEQAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void SondyEQAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer,
+                                           const juce::MidiBuffer& midiMessages) noexcept
 {
     juce::ScopedNoDenormals noDenormals;
+    const auto blockStart = DspLoadMonitor::now();
     auto totalNumInputChannels  = static_cast<size_t>(getTotalNumInputChannels());
     auto totalNumOutputChannels = static_cast<size_t>(getTotalNumOutputChannels());
 
@@ -134,21 +950,401 @@ void SondyEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (static_cast<int>(i), 0, buffer.getNumSamples());
 
-    // Create an AudioBlock for the entire buffer
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    auto& engine = getEngine(SampleType());
+    const auto* chain = bandChain.acquire();
+    if (chain == nullptr || !isPrepared || !engine.isPrepared)
+        return;
+    
+    // The main bus is processed in place; the sidechain, when enabled, only
+    // keys. Without a sidechain the main bus is the whole buffer and is used
+    // as it is, so even the widest layouts build no view (views allocate
+    // from 32 channels up; see maxChannelsWithSidechain).
+    const auto mainBusIsWholeBuffer = getChannelCountOfBus(true, 0) >= buffer.getNumChannels();
+    auto mainView = mainBusIsWholeBuffer ? juce::AudioBuffer<SampleType>() : getBusBuffer(buffer, true, 0);
+    auto& mainBuffer = mainBusIsWholeBuffer ? buffer : mainView;
+    const auto sidechain = getBusBuffer(buffer, true, 1);
+    
+    // The cascades run the published chain with the host's parameters
+    readAutomation(*chain);
+    
+    const auto order = oversamplingOrder.load(std::memory_order_relaxed);
+    
+    if (order != activeOversamplingOrder)
+        setActiveOversamplingOrder(engine, order, automatedChain);
+    else if (automatedChain.serial != engine.cascade.getChainSerial()
+             || filterTopology.load(std::memory_order_relaxed) != engine.cascade.getTopology())
+        routeBandChain(engine, automatedChain);
+    
+    // Sleep while the input is silent and every filter has rung out; the
+    // output is the (silent) input until signal returns
+    const auto inputIsSilent = mainBuffer.getMagnitude(0, mainBuffer.getNumSamples()) < silenceThreshold;
+    
+    if (linearPhaseEnabled.load(std::memory_order_relaxed))
+    {
+        // The convolver has flushed once the input has been silent for its
+        // latency plus the whole kernel
+        const auto flushSamples = linearPhase.getLatencySamples() + linearPhase.getKernelLength();
+        silentInputSamples = inputIsSilent ? juce::jmin(silentInputSamples + mainBuffer.getNumSamples(), flushSamples) : 0;
+        
+        if (silentInputSamples < flushSamples)
+            processLinearPhase(mainBuffer);
+        
+        // The convolver follows automation through the bands; the cascades
+        // jump straight to it, and to the notes played, ready for a switch back
+        const auto midiChanged = handleMidi(midiMessages) && chainTracksMidi;
+        
+        if (automationIsRamping || midiChanged)
+        {
+            applyBandSettings(engine, 1.0f);
+            finishAutomation();
+        }
+    }
+    else
+    {
+        processMinimumPhase(engine, mainBuffer, sidechain, midiMessages, inputIsSilent);
+    }
+    
+    const auto bandsEnd = DspLoadMonitor::now();
+
+    // Hand the block to the analysis thread; a bulk copy and nothing more
+    if (analyzerEnabled.load(std::memory_order_relaxed))
+        analyzerFeed.push(mainBuffer);
+    
+    loadMonitor.record(mainBuffer.getNumSamples(), blockStart, bandsEnd, DspLoadMonitor::now());
+}
 
-    // Process through each band
-    for (auto& band : bands)
+void SondyEQAudioProcessor::processLinearPhase(juce::AudioBuffer<float>& buffer) noexcept
+{
+    linearPhase.process(buffer);
+}
+
+void SondyEQAudioProcessor::processLinearPhase(juce::AudioBuffer<double>& buffer) noexcept
+{
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), linearPhaseBuffer.getNumChannels());
+    const auto maxSamples = linearPhaseBuffer.getNumSamples();
+    
+    for (int start = 0; start < buffer.getNumSamples(); start += maxSamples)
     {
-        band->process(context);
+        const auto numSamples = juce::jmin(maxSamples, buffer.getNumSamples() - start);
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = buffer.getReadPointer(channel, start);
+            auto* dest = linearPhaseBuffer.getWritePointer(channel);
+            
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = static_cast<float>(source[i]);
+        }
+        
+        // Straight on the scratch buffer's channels, so a short final chunk
+        // needs no view (which would allocate from 32 channels up)
+        linearPhase.process(linearPhaseBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = linearPhaseBuffer.getReadPointer(channel);
+            auto* dest = buffer.getWritePointer(channel, start);
+            
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = static_cast<double>(source[i]);
+        }
     }
+}
+
+template <typename SampleType>
+void SondyEQAudioProcessor::processMinimumPhase(Engine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer,
+                                                const juce::AudioBuffer<SampleType>& sidechain,
+                                                const juce::MidiBuffer& midiMessages, bool inputIsSilent) noexcept
+{
+    // Behind a latency stage the previous block must have been silent too,
+    // so nothing is still waiting in the delay or the oversampler
+    const auto latencyStageIsQuiet = activeOversamplingOrder == 0 || previousBlockWasSilent;
+    
+    // Detection runs through silence too, so envelopes release while the cascade sleeps
+    if (dynamics.isActive())
+        dynamics.process(buffer.getArrayOfReadPointers(), buffer.getNumChannels(),
+                         sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), buffer.getNumSamples());
+    
+    const auto numSamples = buffer.getNumSamples();
+    const auto modulated = dynamics.isActive() || chainIsMorphing;
+    const auto numTiles = chainIsMorphing ? updateMorphPositions(numSamples) : dynamics.getNumPeriods();
+    const auto* gainChanges = dynamics.isActive() ? dynamics.getGainChanges() : nullptr;
+    const auto* positions = chainIsMorphing ? morphPositions.data() : nullptr;
+    
+    const auto asleep = inputIsSilent && latencyStageIsQuiet
+                          && engine.cascade.isSettled(silenceThreshold) && engine.oversampledCascade.isSettled(silenceThreshold);
+    
+    // Only bands following MIDI need the block split at its events
+    const auto splitAtEvents = chainTracksMidi && !midiMessages.isEmpty();
+    
+    if (asleep || (!automationIsRamping && !splitAtEvents))
+    {
+        // Nothing moving, or nothing to hear it on: the whole block at once
+        const auto midiChanged = handleMidi(midiMessages) && chainTracksMidi;
+        
+        if (automationIsRamping || midiChanged)
+            applyBandSettings(engine, 1.0f);
+        
+        if (modulated)
+            engine.cascade.setModulation(gainChanges, DynamicsDetector::stride, positions, numTiles);
+        
+        if (!asleep)
+        {
+            // Process through all bands in a single pass, then the oversampled ones
+            processCascade(engine, buffer, 0, numSamples);
+            
+            if (activeOversamplingOrder > 0)
+                processOversamplingStage(engine, buffer, 0, numSamples);
+        }
+    }
+    else
+    {
+        // The block is split at every MIDI event, so the bands tracking it
+        // change on the sample the event is stamped with, and while
+        // automation glides at every tile, each sub-block designed a step
+        // further along. A split costs one batched redesign of the sections
+        // that moved; the modulation of each tile goes with it.
+        constexpr auto tileSize = BiquadCascade<SampleType>::tileSize;
+        const auto numBlockTiles = (numSamples + tileSize - 1) / tileSize;
+        auto event = midiMessages.cbegin();
+        int designedTile = -1;
+        
+        for (int start = 0; start < numSamples;)
+        {
+            bool midiChanged = false;
+            
+            for (; event != midiMessages.cend() && (*event).samplePosition <= start; ++event)
+                midiChanged = midiTracker.handleEvent((*event).data, (*event).numBytes) || midiChanged;
+            
+            // The cascade starts a tile at every segment, so a segment an event
+            // started mid-tile runs only to the tile's end; after that its
+            // tiles, and the modulation of each, line up with the block's again
+            const auto tile = start / tileSize;
+            const auto toTileEnd = automationIsRamping || start % tileSize != 0;
+            auto end = toTileEnd ? juce::jmin(numSamples, (tile + 1) * tileSize) : numSamples;
+            
+            if (event != midiMessages.cend())
+                end = juce::jmin(end, (*event).samplePosition);
+            
+            if ((midiChanged && chainTracksMidi) || (automationIsRamping && tile != designedTile))
+            {
+                applyBandSettings(engine, automationIsRamping ? static_cast<float>(tile + 1) / static_cast<float>(numBlockTiles)
+                                                              : 1.0f);
+                designedTile = tile;
+            }
+            
+            if (modulated)
+            {
+                const auto segmentTiles = juce::jmax(0, juce::jmin(numTiles - tile, (end - start + tileSize - 1) / tileSize));
+                engine.cascade.setModulation(segmentTiles > 0 && gainChanges != nullptr ? gainChanges + tile * DynamicsDetector::stride : nullptr,
+                                             DynamicsDetector::stride,
+                                             segmentTiles > 0 && positions != nullptr ? positions + tile : nullptr,
+                                             segmentTiles);
+            }
+            
+            processCascade(engine, buffer, start, end - start);
+            
+            if (activeOversamplingOrder > 0)
+                processOversamplingStage(engine, buffer, start, end - start);
+            
+            start = end;
+        }
+        
+        // Events stamped past the end of the block take effect for the next one
+        bool lateChange = false;
+        
+        for (; event != midiMessages.cend(); ++event)
+            lateChange = midiTracker.handleEvent((*event).data, (*event).numBytes) || lateChange;
+        
+        if (lateChange && chainTracksMidi)
+            applyBandSettings(engine, 1.0f);
+    }
+    
+    finishAutomation();
+    previousBlockWasSilent = inputIsSilent && buffer.getMagnitude(0, buffer.getNumSamples()) < silenceThreshold;
+}
+
+void SondyEQAudioProcessor::readAutomation(const BandChain& chain) noexcept
+{
+    auto rebuild = chain.serial != automatedChainSource;
+    
+    for (const auto& band : chain.bands)
+    {
+        // Morphing bands follow the morph, not the host
+        if (band.slot < 0 || band.morphs)
+            continue;
+        
+        const auto& values = slotValues[static_cast<size_t>(band.slot)];
+        auto& target = targetSlots[static_cast<size_t>(band.slot)];
+        target.enabled = values[slotEnabled]->load(std::memory_order_relaxed) >= 0.5f;
+        target.parameters.type = static_cast<FilterType>(juce::jlimit(0, numFilterTypes - 1,
+                                                                      juce::roundToInt(values[slotType]->load(std::memory_order_relaxed))));
+        target.parameters.frequency = values[slotFrequency]->load(std::memory_order_relaxed);
+        target.parameters.gain = values[slotGain]->load(std::memory_order_relaxed);
+        target.parameters.q = values[slotQ]->load(std::memory_order_relaxed);
+        target.bandId = band.id;
+        
+        const auto& current = currentSlots[static_cast<size_t>(band.slot)];
+        rebuild = rebuild || target.enabled != current.enabled || target.bandId != current.bandId
+                          || target.parameters.type != current.parameters.type;
+    }
+    
+    if (rebuild)
+        rebuildAutomatedChain(chain);
+    
+    // What remains is a change of frequency, gain or Q, which glides, and
+    // bands following MIDI, which move with every event
+    numMovingBands = 0;
+    automationIsRamping = false;
+    chainTracksMidi = false;
+    
+    for (size_t index = 0; index < automatedChain.bands.size(); ++index)
+    {
+        const auto& band = automatedChain.bands[index];
+        
+        if (band.slot < 0 || band.morphs)
+            continue;
+        
+        const auto ramps = currentSlots[static_cast<size_t>(band.slot)].parameters
+                             != targetSlots[static_cast<size_t>(band.slot)].parameters;
+        automationIsRamping = automationIsRamping || ramps;
+        chainTracksMidi = chainTracksMidi || band.tracking.isActive();
+        
+        if (ramps || band.tracking.isActive())
+            movingBands[static_cast<size_t>(numMovingBands++)] = static_cast<int>(index);
+    }
+}
+
+bool SondyEQAudioProcessor::handleMidi(const juce::MidiBuffer& midiMessages) noexcept
+{
+    bool changed = false;
+    
+    for (const auto metadata : midiMessages)
+        changed = midiTracker.handleEvent(metadata.data, metadata.numBytes) || changed;
+    
+    return changed;
+}
+
+void SondyEQAudioProcessor::rebuildAutomatedChain(const BandChain& chain) noexcept
+{
+    // Reserved for maxBands, so this never allocates
+    automatedChain.bands.clear();
+    
+    for (const auto& band : chain.bands)
+    {
+        if (band.slot < 0 || band.morphs)
+        {
+            // After a morph the band picks up from the host's value
+            if (band.slot >= 0)
+                currentSlots[static_cast<size_t>(band.slot)].enabled = false;
+            
+            automatedChain.bands.push_back(band);
+            continue;
+        }
+        
+        auto& current = currentSlots[static_cast<size_t>(band.slot)];
+        const auto& target = targetSlots[static_cast<size_t>(band.slot)];
+        
+        // A band that was running keeps gliding from where it is; one just
+        // turned on, of a new type or new to the slot starts at its target
+        if (!current.enabled || current.bandId != target.bandId || current.parameters.type != target.parameters.type)
+            current = target;
+        
+        current.enabled = target.enabled;
+        
+        if (!target.enabled)
+            continue;
+        
+        automatedChain.bands.push_back(band);
+        automatedChain.bands.back().parameters = midiTracker.apply(current.parameters, band.tracking);
+    }
+    
+    automatedChainSource = chain.serial;
+    automatedChain.serial = ++automatedChainSerial;
+}
+
+template <typename SampleType>
+void SondyEQAudioProcessor::applyBandSettings(Engine<SampleType>& engine, float position) noexcept
+{
+    for (int i = 0; i < numMovingBands; ++i)
+    {
+        auto& band = automatedChain.bands[static_cast<size_t>(movingBands[static_cast<size_t>(i)])];
+        const auto& current = currentSlots[static_cast<size_t>(band.slot)].parameters;
+        const auto& target = targetSlots[static_cast<size_t>(band.slot)].parameters;
+        
+        // Frequency and Q glide geometrically, as the morph does; tracking goes on top
+        const auto parameters = position < 1.0f && current != target ? BiquadDesign::interpolate(current, target, position)
+                                                                     : target;
+        band.parameters = midiTracker.apply(parameters, band.tracking);
+    }
+    
+    // Only the sections that moved are redesigned; a band turning flat or
+    // crossing the oversampling split reloads the chain
+    if (!engine.cascade.updateParameters(automatedChain) || !engine.oversampledCascade.updateParameters(automatedChain))
+    {
+        automatedChain.serial = ++automatedChainSerial;
+        routeBandChain(engine, automatedChain);
+    }
+    else
+    {
+        // The key filters follow the moved bands too
+        dynamics.updateParameters(automatedChain);
+    }
+}
+
+void SondyEQAudioProcessor::finishAutomation() noexcept
+{
+    for (int i = 0; i < numMovingBands; ++i)
+    {
+        const auto slot = static_cast<size_t>(automatedChain.bands[static_cast<size_t>(movingBands[static_cast<size_t>(i)])].slot);
+        currentSlots[slot].parameters = targetSlots[slot].parameters;
+    }
+    
+    automationIsRamping = false;
+}
+
+int SondyEQAudioProcessor::updateMorphPositions(int numSamples) noexcept
+{
+    constexpr auto tileSize = BiquadCascade<float>::tileSize;
+    const auto numTiles = juce::jmin(static_cast<int>(morphPositions.size()), (numSamples + tileSize - 1) / tileSize);
+    const auto target = morphTargetPosition.load(std::memory_order_relaxed);
+    const auto maxStep = static_cast<float>(tileSize / (morphGlideSeconds * spec.sampleRate));
+    
+    // A glide at a fixed rate; going all the way from A to B takes morphGlideSeconds
+    for (int tile = 0; tile < numTiles; ++tile)
+    {
+        smoothedMorphPosition += juce::jlimit(-maxStep, maxStep, target - smoothedMorphPosition);
+        morphPositions[static_cast<size_t>(tile)] = smoothedMorphPosition;
+    }
+    
+    return numTiles;
+}
 
-    // Notify editor of new audio data
-    if (auto* editor = dynamic_cast<SondyEQAudioProcessorEditor*>(getActiveEditor()))
+template <typename SampleType>
+void SondyEQAudioProcessor::processCascade(Engine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer,
+                                           int startSample, int numSamples) noexcept
+{
+    auto& cascade = engine.cascade;
+    const auto numGroups = cascade.getNumGroups();
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+    SampleType* channels[maxChannels];
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[channel] = buffer.getWritePointer(channel, startSample);
+    
+    if (workerPool == nullptr || numGroups < 2 || cascade.getNumSections() * numSamples < minParallelWorkPerGroup)
     {
-        editor->processBlock(buffer);
+        cascade.process(channels, numChannels, numSamples);
+        return;
     }
+    
+    // One task per group; the pool balances them over whichever threads are awake
+    auto processGroup = [&cascade, channels, numChannels, numSamples](int group) noexcept
+    {
+        cascade.processGroups(channels, numChannels, numSamples, group, group + 1);
+    };
+    
+    workerPool->forEach(numGroups, processGroup);
 }
 
 bool SondyEQAudioProcessor::hasEditor() const
@@ -163,10 +1359,77 @@ juce::AudioProcessorEditor* SondyEQAudioProcessor::createEditor()
 
 void SondyEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
+    // Automation the timer hasn't passed on yet belongs in the state too,
+    // as does a state set from another thread that is still on its way
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        handleUpdateNowIfNeeded();
+        syncBandsWithParameters();
+        getState().writeBinary(destData);
+        return;
+    }
+    
+    // Some hosts ask from another thread, where the bands are off limits
+    PluginState state;
+    
+    {
+        const juce::ScopedLock lock(savedStateLock);
+        
+        if (pendingState != nullptr)
+        {
+            pendingState->writeBinary(destData);
+            return;
+        }
+        
+        state.bands = savedBands;
+    }
+    
+    getSettings(state);
+    state.writeBinary(destData);
 }
 
 void SondyEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    auto state = std::make_unique<PluginState>();
+    
+    if (!state->readBinary(data, static_cast<size_t>(juce::jmax(0, sizeInBytes))))
+        return;
+    
+    // The bands, the parameters and the chain handoff belong to the message
+    // thread. A host restoring from another thread only parses here and
+    // leaves the rest to it; without a message thread nothing else touches them.
+    if (juce::MessageManager::getInstanceWithoutCreating() == nullptr
+        || juce::MessageManager::existsAndIsCurrentThread())
+    {
+        // Newer than anything still waiting
+        {
+            const juce::ScopedLock lock(savedStateLock);
+            pendingState = nullptr;
+        }
+        
+        setState(*state);
+        return;
+    }
+    
+    {
+        const juce::ScopedLock lock(savedStateLock);
+        pendingState = std::move(state);
+    }
+    
+    triggerAsyncUpdate();
+}
+
+void SondyEQAudioProcessor::handleAsyncUpdate()
+{
+    std::unique_ptr<PluginState> state;
+    
+    {
+        const juce::ScopedLock lock(savedStateLock);
+        state = std::move(pendingState);
+    }
+    
+    if (state != nullptr)
+        setState(*state);
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
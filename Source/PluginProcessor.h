@@ -14,13 +14,30 @@
 #include <juce_gui_extra/juce_gui_extra.h>
 #include <juce_dsp/juce_dsp.h>
 #include "EQBand.h"
+#include "BandChain.h"
+#include "BiquadCascade.h"
+#include "LockFree.h"
+#include "LinearPhase.h"
+#include "DspLoad.h"
+#include "WorkerPool.h"
+#include "Dynamics.h"
+#include "PluginState.h"
+#include "Morph.h"
+#include "MidiTracking.h"
 
-// Forward declare EQInterface to avoid circular dependency
-class EQInterface;
-
-class SondyEQAudioProcessor : public juce::AudioProcessor
+class SondyEQAudioProcessor : public juce::AudioProcessor,
+                              private juce::Timer,
+                              private juce::AsyncUpdater
 {
 public:
+    // Widest bus layout accepted (e.g. 7.1.4, 3rd-order Ambisonics, discrete beds)
+    static constexpr int maxChannels = 64;
+    
+    // Widest main bus alongside an enabled sidechain. The main bus then has
+    // to be viewed apart from the sidechain, and juce::AudioBuffer views
+    // allocate their channel list on the audio thread from 32 channels up.
+    static constexpr int maxChannelsWithSidechain = 31;
+    
     SondyEQAudioProcessor();
     ~SondyEQAudioProcessor() override;
 
@@ -30,6 +47,8 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -50,14 +69,303 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    // Public access to bands for the editor
+    // Public access to bands for the editor (message thread only)
     std::vector<std::unique_ptr<EQBand>>& getBands() { return bands; }
     void addBand(std::unique_ptr<EQBand> band);
     void removeBand(EQBand* band);
+    
+    // Publishes the current band settings to the audio thread; call after editing a band
+    void updateBandChain();
+    
+    // The whole session at once: bands, oversampling and linear phase.
+    // setState() reuses the existing EQBands, designs every band's
+    // coefficients in one batch and publishes a single chain, so recalling a
+    // session is cheap even across hundreds of instances, and safe while
+    // audio is running. Message thread.
+    PluginState getState() const;
+    void setState(const PluginState& state);
+    
+    // Changes whenever setState() or a morph replaces the band list, so an
+    // open editor knows to let go of any band it holds on to
+    juce::uint32 getBandListSerial() const { return bandListSerial.load(); }
+    
+    // Host automation. Every band is mirrored in one of a fixed set of
+    // parameter slots (on, type, frequency, gain and Q), taking the lowest
+    // free slot when it is added. Edits to the bands are sent to the host
+    // with updateBandChain(); automation reaches the audio thread straight
+    // from the parameters, gliding from block start to its new value in
+    // sub-blocks of one cascade tile, each with one coefficient update, and
+    // reaches the bands a little later. Turning a slot on adds a band,
+    // turning it off removes one.
+    juce::AudioProcessorValueTreeState& getValueTreeState() { return valueTreeState; }
+    void beginParameterGesture(int slot);
+    void endParameterGesture(int slot);
+    
+    // Changes whenever automation changed the bands' settings, so an open
+    // editor knows to redraw them
+    juce::uint32 getBandSettingsSerial() const { return bandSettingsSerial.load(); }
+    
+    // A/B snapshots of the bands. Recalling one glides to it, and the morph
+    // position moves continuously between the two (0 = A, 1 = B); either
+    // way the audio thread interpolates frequency, gain and Q per control
+    // period, so nothing clicks. The bands follow the morph, for display;
+    // editing one ends the morph where it stands. Message thread.
+    static constexpr int numSnapshots = 2;
+    void storeSnapshot(int slot);
+    bool hasSnapshot(int slot) const;
+    void recallSnapshot(int slot);
+    void setMorphPosition(float newPosition);
+    float getMorphPosition() const { return morphPosition; }
+    bool isMorphing() const { return !morphBands.empty(); }
+    
+    // Spectrum analyzer feed. The editor enables it while open; when disabled
+    // processBlock doesn't even copy the block.
+    SpscAudioRing& getAnalyzerFeed() { return analyzerFeed; }
+    void setAnalyzerEnabled(bool shouldBeEnabled) { analyzerEnabled = shouldBeEnabled; }
+    
+    // Oversampling around the bands that need it: 0 = off, 1 = 2x, 2 = 4x, 3 = 8x.
+    // Message thread; reports the new latency to the host.
+    static constexpr int maxOversamplingOrder = 3;
+    void setOversamplingOrder(int newOrder);
+    int getOversamplingOrder() const { return oversamplingOrder.load(); }
+    
+    // Linear-phase mode replaces the biquads with an FIR convolution of the
+    // same response. The partition size trades latency against CPU; changing
+    // it reallocates, so processing is briefly suspended. Message thread.
+    void setLinearPhaseEnabled(bool shouldBeEnabled);
+    bool isLinearPhaseEnabled() const { return linearPhaseEnabled.load(); }
+    void setLinearPhasePartitionSize(int newPartitionSize);
+    int getLinearPhasePartitionSize() const { return linearPhasePartitionSize; }
+    
+    // How the minimum-phase path realises the bands: biquads, or
+    // state-variable filters (see BiquadCascade), which move every sample
+    // under dynamics and morphing and take automation without zipper noise,
+    // for a little more CPU. Switching restarts the filters. Message thread.
+    void setFilterTopology(FilterTopology newTopology) { filterTopology = newTopology; }
+    FilterTopology getFilterTopology() const { return filterTopology.load(); }
+    
+    // Timing of every processBlock against its real-time budget. Any thread.
+    DspLoadStatistics getDspLoadStatistics() const { return loadMonitor.getStatistics(); }
+    void resetDspLoadStatistics() { loadMonitor.requestReset(); }
 
 private:
     std::vector<std::unique_ptr<EQBand>> bands;
-    juce::dsp::ProcessSpec spec;
+    std::atomic<juce::uint32> bandListSerial { 0 };
+    
+    // Overwrites the bands in place with one batched design, adding or
+    // dropping bands only to match the new count
+    void restoreBands(const std::vector<PluginState::Band>& newBands);
+    
+    // A copy of the bands, refreshed whenever they change, for hosts that
+    // ask for the state from a thread other than the message thread, where
+    // the bands themselves are off limits
+    juce::CriticalSection savedStateLock;
+    std::vector<PluginState::Band> savedBands;
+    void saveBands();
+    
+    // A state a host set from another thread, under savedStateLock, until
+    // the message thread applies it
+    std::unique_ptr<PluginState> pendingState;
+    void handleAsyncUpdate() override;
+    
+    // Everything in the state but the bands; any thread
+    void getSettings(PluginState& state) const;
+    
+    // Parameter slots: raw values for the audio thread and, on the message
+    // thread, each parameter's normalised value as of the last sync either
+    // way, so only actual changes are passed on
+    enum SlotParameter { slotEnabled, slotType, slotFrequency, slotGain, slotQ, numSlotParameters };
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    static juce::String getParameterId(int slot, SlotParameter parameter);
+    juce::AudioProcessorValueTreeState valueTreeState;
+    std::array<std::array<juce::RangedAudioParameter*, numSlotParameters>, BandChain::maxBands> slotParameters {};
+    std::array<std::array<std::atomic<float>*, numSlotParameters>, BandChain::maxBands> slotValues {};
+    std::array<std::array<float, numSlotParameters>, BandChain::maxBands> syncedValues {};
+    std::atomic<juce::uint32> bandSettingsSerial { 0 };
+    
+    void pushBandsToParameters();
+    void setSlotParameter(int slot, SlotParameter parameter, float value);
+    
+    // Brings the bands in line with automation, at syncRateHz
+    static constexpr int syncRateHz = 30;
+    void syncBandsWithParameters();
+    void timerCallback() override;
+    
+    // A band whose slot is automated off, kept with the settings the
+    // parameters don't cover (channels, dynamics and tracking) until the
+    // slot comes back on, or another band takes it
+    std::array<PluginState::Band, BandChain::maxBands> disabledSlotBands;
+    std::array<bool, BandChain::maxBands> disabledSlotIsStored {};
+    
+    // Audio thread: the chain the cascades actually run, the published one
+    // with the parameters of every slotted band taken from the host. A
+    // band's current settings are what the cascades hold at block start and
+    // its target what the host has set; bands between the two glide over
+    // the block.
+    struct SlotSettings
+    {
+        bool enabled = false;
+        BiquadDesign::Parameters parameters;
+        juce::uint32 bandId = 0;
+    };
+    
+    BandChain automatedChain;
+    juce::uint64 automatedChainSource = 0, automatedChainSerial = 0;
+    std::array<SlotSettings, BandChain::maxBands> currentSlots {}, targetSlots {};
+    
+    // Bands redesigned as the block goes: gliding or following MIDI
+    std::array<int, BandChain::maxBands> movingBands {};
+    int numMovingBands = 0;
+    bool automationIsRamping = false;
+    bool chainTracksMidi = false;
+    
+    // Reads the parameters, rebuilding the chain when a band turned on or
+    // off, changed type or the published chain changed
+    void readAutomation(const BandChain& chain) noexcept;
+    void rebuildAutomatedChain(const BandChain& chain) noexcept;
+    
+    // Notes and controllers for tracked bands, fed from processBlock's MIDI
+    MidiTracker midiTracker;
+    
+    // Takes every event of the block at once; true if a tracked band moved
+    bool handleMidi(const juce::MidiBuffer& midiMessages) noexcept;
+    
+    std::array<std::vector<PluginState::Band>, numSnapshots> snapshots;
+    std::array<bool, numSnapshots> snapshotIsStored {};
+    
+    // The morph the bands follow, empty when not morphing
+    std::vector<MorphBand> morphBands;
+    float morphPosition = 0.0f;
+    bool bandsFollowMorph() const;
+    
+    // The morph position the audio thread glides towards, where a new morph
+    // starts from, and where the glide has got to: it covers the whole range
+    // in morphGlideSeconds, one step per tile of the cascade
+    static constexpr double morphGlideSeconds = 0.1;
+    std::atomic<float> morphTargetPosition { 0.0f }, morphStartPosition { 0.0f };
+    float smoothedMorphPosition = 0.0f;
+    bool chainIsMorphing = false;
+    std::vector<float> morphPositions;
+    int updateMorphPositions(int numSamples) noexcept;
+    juce::dsp::ProcessSpec spec { 0.0, 0, 0 };
+    
+    // Snapshot handoff between the message thread and processBlock
+    BandChainHandoff bandChain;
+    
+    // The minimum-phase path at one sample precision. Hosts with a 64-bit
+    // mix engine get the double engine, so their buffers are processed as
+    // they are and low, high-Q bands keep exact double-precision poles; only
+    // the engine for the precision in use is prepared.
+    template <typename SampleType>
+    struct Engine
+    {
+        // Runs all bands of the active chain in one pass over the buffer
+        BiquadCascade<SampleType> cascade;
+        
+        // Bands behind the oversampler, see oversamplingThreshold
+        BiquadCascade<SampleType> oversampledCascade;
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, maxOversamplingOrder> oversamplers;
+        juce::dsp::DelayLine<SampleType, juce::dsp::DelayLineInterpolationTypes::None> latencyDelay;
+        juce::AudioBuffer<SampleType> dryBuffer;
+        bool isPrepared = false;
+    };
+    
+    Engine<float> floatEngine;
+    Engine<double> doubleEngine;
+    Engine<float>& getEngine(float) noexcept { return floatEngine; }
+    Engine<double>& getEngine(double) noexcept { return doubleEngine; }
+    
+    template <typename SampleType>
+    void prepareEngine(Engine<SampleType>& engine, int samplesPerBlock);
+    
+    // Moves the gliding bands of the automated chain to a point of their
+    // glide, 0 to 1, tracked bands to the notes so far, and the engine's
+    // cascades with them
+    template <typename SampleType>
+    void applyBandSettings(Engine<SampleType>& engine, float position) noexcept;
+    void finishAutomation() noexcept;
+    
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages) noexcept;
+    bool isPrepared = false;
+    
+    // Wide layouts spread the cascade's channel groups over a few helper
+    // threads. A block only goes parallel when each group has at least
+    // minParallelWorkPerGroup section-samples of work (e.g. 8 bands of
+    // 2048 samples); below that, waking the helpers costs more than it saves.
+    static constexpr int maxWorkerThreads = 7;
+    static constexpr int minParallelWorkPerGroup = 16384;
+    std::unique_ptr<WorkerPool> workerPool;
+    
+    template <typename SampleType>
+    void processCascade(Engine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer,
+                        int startSample, int numSamples) noexcept;
+    
+    // Bands at or above this fraction of the sample rate cramp noticeably
+    // and move to a second cascade running behind the oversampler. With no
+    // such band the oversampler is skipped and a plain delay keeps the
+    // reported latency; switching between the two crossfades over one block.
+    static constexpr double oversamplingThreshold = 0.125;
+    std::array<int, maxOversamplingOrder + 1> oversamplingLatency {};
+    std::atomic<int> oversamplingOrder { 0 };
+    int activeOversamplingOrder = 0;
+    std::atomic<FilterTopology> filterTopology { FilterTopology::Biquad };
+    bool oversamplingEngaged = false;
+    bool previousBlockWasSilent = true;
+    
+    // Level detection for dynamic bands, keyed from the input or the
+    // sidechain bus. Dynamic bands always run in the base-rate cascade, and
+    // the linear-phase path treats them as static bands at their set gain.
+    DynamicsDetector dynamics;
+    
+    // Linear-phase path; kernels are designed on its own thread. It convolves
+    // in float at either precision, as an FIR has no feedback for rounding
+    // to build up in; double blocks go through linearPhaseBuffer.
+    LinearPhaseEQ linearPhase;
+    juce::AudioBuffer<float> linearPhaseBuffer;
+    std::atomic<bool> linearPhaseEnabled { false };
+    std::atomic<int> linearPhasePartitionSize { 1024 };
+    int silentInputSamples = 0;
+    
+    std::vector<BiquadDesign::Parameters> getBandParameters() const;
+    void updateLatency();
+    
+    /** Designs a kernel synchronously if the convolver has none yet, so the
+        audio thread never switches to linear phase without one. */
+    void designFirstKernel();
+    
+    void processLinearPhase(juce::AudioBuffer<float>& buffer) noexcept;
+    void processLinearPhase(juce::AudioBuffer<double>& buffer) noexcept;
+    
+    template <typename SampleType>
+    void setActiveOversamplingOrder(Engine<SampleType>& engine, int newOrder, const BandChain& chain) noexcept;
+    
+    template <typename SampleType>
+    void routeBandChain(Engine<SampleType>& engine, const BandChain& chain) noexcept;
+    
+    template <typename SampleType>
+    void processMinimumPhase(Engine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer,
+                             const juce::AudioBuffer<SampleType>& sidechain,
+                             const juce::MidiBuffer& midiMessages, bool inputIsSilent) noexcept;
+    
+    template <typename SampleType>
+    void processOversamplingStage(Engine<SampleType>& engine, juce::AudioBuffer<SampleType>& buffer,
+                                  int startSample, int numSamples) noexcept;
+    
+    // Below this (-120 dBFS) input counts as silence and filter state as decayed
+    static constexpr float silenceThreshold = 1.0e-6f;
+    
+    // Computed from the pole radii of the active bands whenever the chain changes
+    std::atomic<double> tailLengthSeconds { 0.0 };
+    static constexpr double maxTailLengthSeconds = 30.0;
+    
+    // Audio thread -> analysis thread; sized once so neither side allocates
+    static constexpr int analyzerChannels = 2;
+    static constexpr int analyzerFeedCapacity = 1 << 15;
+    SpscAudioRing analyzerFeed { analyzerChannels, analyzerFeedCapacity };
+    std::atomic<bool> analyzerEnabled { false };
+    
+    DspLoadMonitor loadMonitor;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SondyEQAudioProcessor)
 };
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include "PluginState.h"
+#include "BandChain.h"
+#include <cmath>
+
+namespace
+{
+    constexpr juce::uint32 stateMagic = 0x53514553;   // "SEQS" read as little-endian
+    constexpr int headerSize = 14;
+    constexpr int recordSize = 36;
+
+    // Type, target, flags and frequency/gain/q: anything shorter is not a band
+    constexpr int minRecordSize = 16;
+
+    // Where each later group of fields ends
+    constexpr int dynamicsRecordSize = 32;
+    constexpr int trackingRecordSize = 36;
+
+    enum BandFlags { dynamicFlag = 1 << 0, sidechainFlag = 1 << 1 };
+    enum GlobalFlags { linearPhaseFlag = 1 << 0, stateVariableFlag = 1 << 1 };
+
+    const std::pair<const char*, FilterType> filterTypeNames[] =
+    {
+        { "LowShelf",  FilterType::LowShelf },
+        { "HighShelf", FilterType::HighShelf },
+        { "Peak",      FilterType::Peak },
+        { "Notch",     FilterType::Notch },
+        { "LowPass",   FilterType::LowPass },
+        { "HighPass",  FilterType::HighPass }
+    };
+
+    const std::pair<const char*, BandTracking::GainSource> gainSourceNames[] =
+    {
+        { "fixed",      BandTracking::GainSource::fixed },
+        { "velocity",   BandTracking::GainSource::velocity },
+        { "controller", BandTracking::GainSource::controller }
+    };
+
+    const std::pair<const char*, FilterTopology> topologyNames[] =
+    {
+        { "Biquad",        FilterTopology::Biquad },
+        { "StateVariable", FilterTopology::StateVariable }
+    };
+
+    const std::pair<const char*, ChannelTarget> channelTargetNames[] =
+    {
+        { "Stereo", ChannelTarget::Stereo },
+        { "Left",   ChannelTarget::Left },
+        { "Right",  ChannelTarget::Right },
+        { "Mid",    ChannelTarget::Mid },
+        { "Side",   ChannelTarget::Side }
+    };
+
+    template <typename Enum, size_t numNames>
+    bool parseName(const std::pair<const char*, Enum> (&names)[numNames], const juce::String& name, Enum& result)
+    {
+        for (const auto& entry : names)
+        {
+            if (name.equalsIgnoreCase(entry.first))
+            {
+                result = entry.second;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template <typename Enum, size_t numNames>
+    const char* getName(const std::pair<const char*, Enum> (&names)[numNames], Enum value)
+    {
+        for (const auto& entry : names)
+            if (entry.second == value)
+                return entry.first;
+
+        return names[0].first;
+    }
+
+    template <typename Enum, size_t numNames>
+    bool isKnown(const std::pair<const char*, Enum> (&names)[numNames], int value)
+    {
+        for (const auto& entry : names)
+            if (static_cast<int>(entry.second) == value)
+                return true;
+
+        return false;
+    }
+
+    /** Replaces anything non-finite (a corrupt or hand-edited state) with the default. */
+    float readFinite(juce::MemoryInputStream& stream, float defaultValue)
+    {
+        const auto value = stream.readFloat();
+        return std::isfinite(value) ? value : defaultValue;
+    }
+}
+
+void PluginState::writeBinary(juce::MemoryBlock& destData) const
+{
+    const auto numBands = juce::jmin(static_cast<int>(bands.size()), BandChain::maxBands);
+
+    // One allocation for the whole state
+    destData.setSize(0);
+    destData.ensureSize(static_cast<size_t>(headerSize + numBands * recordSize));
+    juce::MemoryOutputStream stream(destData, false);
+
+    stream.writeInt(static_cast<int>(stateMagic));
+    stream.writeShort(static_cast<short>(currentVersion));
+    stream.writeShort(static_cast<short>(recordSize));
+    stream.writeByte(static_cast<char>(oversamplingOrder));
+    stream.writeByte(static_cast<char>((linearPhase ? linearPhaseFlag : 0)
+                                       | (topology == FilterTopology::StateVariable ? stateVariableFlag : 0)));
+    stream.writeShort(static_cast<short>(juce::jlimit(0, 0xffff, linearPhasePartitionSize)));
+    stream.writeShort(static_cast<short>(numBands));
+
+    for (int i = 0; i < numBands; ++i)
+    {
+        const auto& band = bands[static_cast<size_t>(i)];
+        const auto& dynamics = band.dynamics;
+
+        stream.writeByte(static_cast<char>(band.parameters.type));
+        stream.writeByte(static_cast<char>(band.target));
+        stream.writeByte(static_cast<char>((dynamics.enabled ? dynamicFlag : 0)
+                                           | (dynamics.useSidechain ? sidechainFlag : 0)));
+        stream.writeByte(0);
+        stream.writeFloat(band.parameters.frequency);
+        stream.writeFloat(band.parameters.gain);
+        stream.writeFloat(band.parameters.q);
+        stream.writeFloat(dynamics.threshold);
+        stream.writeFloat(dynamics.ratio);
+        stream.writeFloat(dynamics.attack);
+        stream.writeFloat(dynamics.release);
+
+        const auto& tracking = band.tracking;
+        stream.writeByte(static_cast<char>(tracking.harmonic));
+        stream.writeByte(static_cast<char>(tracking.gainSource));
+        stream.writeByte(static_cast<char>(tracking.controller));
+        stream.writeByte(0);
+    }
+
+    stream.flush();
+}
+
+bool PluginState::readBinary(const void* data, size_t sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < static_cast<size_t>(headerSize))
+        return false;
+
+    juce::MemoryInputStream stream(data, sizeInBytes, false);
+
+    if (static_cast<juce::uint32>(stream.readInt()) != stateMagic)
+        return false;
+
+    stream.readShort();   // version; records only grow, so any version reads
+    const auto storedRecordSize = static_cast<int>(static_cast<juce::uint16>(stream.readShort()));
+    const auto storedOversamplingOrder = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+    const auto globalFlags = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+    const auto storedPartitionSize = static_cast<int>(static_cast<juce::uint16>(stream.readShort()));
+    const auto numBands = static_cast<int>(static_cast<juce::uint16>(stream.readShort()));
+
+    if (storedRecordSize < minRecordSize || numBands > BandChain::maxBands
+        || stream.getNumBytesRemaining() < static_cast<juce::int64>(numBands) * storedRecordSize)
+        return false;
+
+    std::vector<Band> newBands(static_cast<size_t>(numBands));
+
+    for (auto& band : newBands)
+    {
+        const auto recordEnd = stream.getPosition() + storedRecordSize;
+        const auto type = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+        const auto target = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+        const auto flags = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+        stream.readByte();
+
+        if (isKnown(filterTypeNames, type))
+            band.parameters.type = static_cast<FilterType>(type);
+
+        if (isKnown(channelTargetNames, target))
+            band.target = static_cast<ChannelTarget>(target);
+
+        auto& parameters = band.parameters;
+        parameters.frequency = readFinite(stream, parameters.frequency);
+        parameters.gain = readFinite(stream, parameters.gain);
+        parameters.q = readFinite(stream, parameters.q);
+
+        auto& dynamics = band.dynamics;
+        dynamics.enabled = (flags & dynamicFlag) != 0;
+        dynamics.useSidechain = (flags & sidechainFlag) != 0;
+
+        if (storedRecordSize >= dynamicsRecordSize)
+        {
+            dynamics.threshold = readFinite(stream, dynamics.threshold);
+            dynamics.ratio = readFinite(stream, dynamics.ratio);
+            dynamics.attack = readFinite(stream, dynamics.attack);
+            dynamics.release = readFinite(stream, dynamics.release);
+        }
+
+        if (storedRecordSize >= trackingRecordSize)
+        {
+            auto& tracking = band.tracking;
+            const auto harmonic = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+            const auto gainSource = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+            const auto controller = static_cast<int>(static_cast<juce::uint8>(stream.readByte()));
+
+            if (harmonic <= BandTracking::maxHarmonic)
+                tracking.harmonic = harmonic;
+
+            if (isKnown(gainSourceNames, gainSource))
+                tracking.gainSource = static_cast<BandTracking::GainSource>(gainSource);
+
+            if (controller < 128)
+                tracking.controller = controller;
+        }
+
+        // Past the fields this version knows
+        stream.setPosition(recordEnd);
+    }
+
+    bands = std::move(newBands);
+    oversamplingOrder = storedOversamplingOrder;
+    linearPhase = (globalFlags & linearPhaseFlag) != 0;
+    topology = (globalFlags & stateVariableFlag) != 0 ? FilterTopology::StateVariable : FilterTopology::Biquad;
+
+    if (storedPartitionSize > 0)
+        linearPhasePartitionSize = storedPartitionSize;
+
+    return true;
+}
+
+std::unique_ptr<juce::XmlElement> PluginState::toXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement>("SondyEQPreset");
+    xml->setAttribute("oversampling", oversamplingOrder);
+    xml->setAttribute("linearPhase", linearPhase ? 1 : 0);
+    xml->setAttribute("linearPhaseBlockSize", linearPhasePartitionSize);
+    xml->setAttribute("topology", juce::String(getName(topologyNames, topology)));
+
+    for (const auto& band : bands)
+    {
+        auto* element = xml->createNewChildElement("Band");
+        element->setAttribute("type", juce::String(getName(filterTypeNames, band.parameters.type)));
+        element->setAttribute("frequency", static_cast<double>(band.parameters.frequency));
+        element->setAttribute("gain", static_cast<double>(band.parameters.gain));
+        element->setAttribute("q", static_cast<double>(band.parameters.q));
+        element->setAttribute("channels", juce::String(getName(channelTargetNames, band.target)));
+
+        // Static bands leave the dynamics out, as a hand-written preset would
+        const auto& dynamics = band.dynamics;
+
+        if (dynamics.enabled)
+        {
+            element->setAttribute("dynamic", 1);
+            element->setAttribute("sidechain", dynamics.useSidechain ? 1 : 0);
+            element->setAttribute("threshold", static_cast<double>(dynamics.threshold));
+            element->setAttribute("ratio", static_cast<double>(dynamics.ratio));
+            element->setAttribute("attack", static_cast<double>(dynamics.attack));
+            element->setAttribute("release", static_cast<double>(dynamics.release));
+        }
+
+        // Likewise MIDI tracking, for bands that don't track
+        const auto& tracking = band.tracking;
+
+        if (tracking.harmonic > 0)
+            element->setAttribute("harmonic", tracking.harmonic);
+
+        if (tracking.gainSource != BandTracking::GainSource::fixed)
+        {
+            element->setAttribute("gainSource", juce::String(getName(gainSourceNames, tracking.gainSource)));
+            element->setAttribute("controller", tracking.controller);
+        }
+    }
+
+    return xml;
+}
+
+juce::String PluginState::fromXml(const juce::XmlElement& xml)
+{
+    if (!xml.hasTagName("SondyEQPreset"))
+        return "not a SondyEQ preset";
+
+    auto newTopology = FilterTopology::Biquad;
+
+    if (!parseName(topologyNames, xml.getStringAttribute("topology", "Biquad"), newTopology))
+        return "unknown topology: " + xml.getStringAttribute("topology");
+
+    std::vector<Band> newBands;
+
+    for (const auto* element : xml.getChildWithTagNameIterator("Band"))
+    {
+        Band band;
+
+        if (!parseName(filterTypeNames, element->getStringAttribute("type", "Peak"), band.parameters.type))
+            return "unknown filter type: " + element->getStringAttribute("type");
+
+        if (!parseName(channelTargetNames, element->getStringAttribute("channels", "Stereo"), band.target))
+            return "unknown channels: " + element->getStringAttribute("channels");
+
+        band.parameters.frequency = static_cast<float>(element->getDoubleAttribute("frequency", 1000.0));
+        band.parameters.gain = static_cast<float>(element->getDoubleAttribute("gain", 0.0));
+        band.parameters.q = static_cast<float>(element->getDoubleAttribute("q", 1.0));
+
+        auto& dynamics = band.dynamics;
+        dynamics.enabled = element->getBoolAttribute("dynamic", false);
+        dynamics.useSidechain = element->getBoolAttribute("sidechain", false);
+        dynamics.threshold = static_cast<float>(element->getDoubleAttribute("threshold", dynamics.threshold));
+        dynamics.ratio = static_cast<float>(element->getDoubleAttribute("ratio", dynamics.ratio));
+        dynamics.attack = static_cast<float>(element->getDoubleAttribute("attack", dynamics.attack));
+        dynamics.release = static_cast<float>(element->getDoubleAttribute("release", dynamics.release));
+
+        if (!parseName(gainSourceNames, element->getStringAttribute("gainSource", "fixed"), band.tracking.gainSource))
+            return "unknown gain source: " + element->getStringAttribute("gainSource");
+
+        auto& tracking = band.tracking;
+        tracking.harmonic = juce::jlimit(0, BandTracking::maxHarmonic, element->getIntAttribute("harmonic", 0));
+        tracking.controller = juce::jlimit(0, 127, element->getIntAttribute("controller", tracking.controller));
+        newBands.push_back(band);
+    }
+
+    if (newBands.size() > static_cast<size_t>(BandChain::maxBands))
+        return "too many bands (at most " + juce::String(BandChain::maxBands) + ")";
+
+    bands = std::move(newBands);
+    oversamplingOrder = xml.getIntAttribute("oversampling", 0);
+    linearPhase = xml.getBoolAttribute("linearPhase", false);
+    linearPhasePartitionSize = xml.getIntAttribute("linearPhaseBlockSize", 1024);
+    topology = newTopology;
+    return {};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+#include "EQBand.h"
+#include "StateVariableDesign.h"
+
+/** Everything a saved instance consists of: the bands, then the global
+    settings. It is what getStateInformation() writes and what
+    setStateInformation() restores in one step, and doubles as the render
+    tool's preset.
+
+    The binary form is what hosts store, so it is small and quick to parse:
+
+        uint32  magic ('SEQS')
+        uint16  version
+        uint16  record size in bytes
+        uint8   oversampling order
+        uint8   flags (bit 0: linear phase, bit 1: state-variable topology)
+        uint16  linear-phase partition size
+        uint16  band count
+        then one packed record per band:
+            uint8   filter type
+            uint8   channel target
+            uint8   flags (bit 0: dynamic, bit 1: keyed from the sidechain)
+            uint8   reserved
+            float   frequency, gain, q
+            float   threshold, ratio, attack, release
+            uint8   tracked harmonic (0: none)      since version 2
+            uint8   gain source (0: fixed, 1: velocity, 2: controller)
+            uint8   controller number
+            uint8   reserved
+
+    All little-endian. Later versions only ever append fields to the record,
+    so a reader skips whatever lies past the fields it knows, and fields a
+    shorter record lacks keep their defaults.
+
+    The XML form holds the same data as a <SondyEQPreset> element, for
+    diffing sessions and hand-written presets.
+*/
+struct PluginState
+{
+    struct Band
+    {
+        BiquadDesign::Parameters parameters;
+        ChannelTarget target = ChannelTarget::Stereo;
+        BandDynamics dynamics;
+        BandTracking tracking;
+    };
+
+    std::vector<Band> bands;
+    int oversamplingOrder = 0;
+    bool linearPhase = false;
+    int linearPhasePartitionSize = 1024;
+    FilterTopology topology = FilterTopology::Biquad;
+
+    static constexpr int currentVersion = 2;
+
+    void writeBinary(juce::MemoryBlock& destData) const;
+
+    /** False, leaving this state untouched, if the data isn't a SondyEQ state. */
+    bool readBinary(const void* data, size_t sizeInBytes);
+
+    std::unique_ptr<juce::XmlElement> toXml() const;
+
+    /** Returns an error message, or an empty string on success. */
+    juce::String fromXml(const juce::XmlElement& xml);
+};
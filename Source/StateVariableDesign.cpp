@@ -0,0 +1,120 @@
+#include "StateVariableDesign.h"
+#include <cmath>
+
+namespace StateVariableDesign
+{
+
+namespace
+{
+    constexpr int batchSize = 16;
+
+    double clampFrequency(float frequency, double sampleRate) noexcept
+    {
+        // The same range as the biquad designs, so both topologies agree everywhere
+        return juce::jlimit(2.0, sampleRate * 0.499, static_cast<double>(frequency));
+    }
+
+    /** The 7/6 Pade approximant of tan, very accurate up to pi / 4. */
+    double padeTan(double x) noexcept
+    {
+        const auto x2 = x * x;
+        const auto numerator = x * (-135135.0 + x2 * (17325.0 + x2 * (-378.0 + x2)));
+        const auto denominator = -135135.0 + x2 * (62370.0 + x2 * (-3150.0 + 28.0 * x2));
+        return numerator / denominator;
+    }
+
+    /** Designs one band from g = tan(pi f / fs). */
+    template <typename SampleType>
+    void designFromTan(const BiquadDesign::Parameters& p, double tanHalfW, CoefficientsOf<SampleType>& result) noexcept
+    {
+        const auto q = juce::jmax(0.001, static_cast<double>(p.q));
+        auto g = tanHalfW;
+        auto k = 1.0 / q;
+        double m0 = 0.0, m1 = 0.0, m2 = 0.0;
+
+        switch (p.type)
+        {
+            case FilterType::LowPass:
+                m2 = 1.0;
+                break;
+
+            case FilterType::HighPass:
+                m0 = 1.0; m1 = -k; m2 = -1.0;
+                break;
+
+            case FilterType::Notch:
+                m0 = 1.0; m1 = -k;
+                break;
+
+            case FilterType::Peak:
+            {
+                const auto A = std::pow(10.0, p.gain / 40.0);
+                k = 1.0 / (q * A);
+                m0 = 1.0; m1 = k * (A * A - 1.0);
+                break;
+            }
+
+            case FilterType::LowShelf:
+            {
+                const auto A = std::pow(10.0, p.gain / 40.0);
+                g /= std::sqrt(A);
+                m0 = 1.0; m1 = k * (A - 1.0); m2 = A * A - 1.0;
+                break;
+            }
+
+            case FilterType::HighShelf:
+            default:
+            {
+                const auto A = std::pow(10.0, p.gain / 40.0);
+                g *= std::sqrt(A);
+                m0 = A * A; m1 = k * (1.0 - A) * A; m2 = 1.0 - A * A;
+                break;
+            }
+        }
+
+        result = { static_cast<SampleType>(g), static_cast<SampleType>(k), static_cast<SampleType>(m0),
+                   static_cast<SampleType>(m1), static_cast<SampleType>(m2) };
+    }
+}
+
+double fastTan(double x) noexcept
+{
+    // Past pi / 4 the approximant drifts, so use tan(x) = 1 / tan(pi / 2 - x)
+    constexpr auto quarterPi = juce::MathConstants<double>::pi * 0.25;
+    return x <= quarterPi ? padeTan(x) : 1.0 / padeTan(juce::MathConstants<double>::halfPi - x);
+}
+
+template <typename SampleType>
+void design(const BiquadDesign::Parameters& parameters, double sampleRate, CoefficientsOf<SampleType>& result) noexcept
+{
+    const auto halfW = juce::MathConstants<double>::pi * clampFrequency(parameters.frequency, sampleRate) / sampleRate;
+    designFromTan(parameters, fastTan(halfW), result);
+}
+
+template <typename SampleType>
+void designBatch(const BiquadDesign::Parameters* parameters, CoefficientsOf<SampleType>* results,
+                 int numBands, double sampleRate) noexcept
+{
+    const auto radiansPerHz = juce::MathConstants<double>::pi / sampleRate;
+
+    // As BiquadDesign::designBatch: fixed-size chunks on the stack, with the
+    // tan pass as a straight loop over plain arrays
+    for (int start = 0; start < numBands; start += batchSize)
+    {
+        const auto count = juce::jmin(batchSize, numBands - start);
+        double tanHalfW[batchSize];
+
+        for (int i = 0; i < count; ++i)
+            tanHalfW[i] = fastTan(radiansPerHz * clampFrequency(parameters[start + i].frequency, sampleRate));
+
+        for (int i = 0; i < count; ++i)
+            designFromTan(parameters[start + i], tanHalfW[i], results[start + i]);
+    }
+}
+
+template void design<float>(const BiquadDesign::Parameters&, double, CoefficientsOf<float>&) noexcept;
+template void design<double>(const BiquadDesign::Parameters&, double, CoefficientsOf<double>&) noexcept;
+template void designBatch<float>(const BiquadDesign::Parameters*, CoefficientsOf<float>*, int, double) noexcept;
+template void designBatch<double>(const BiquadDesign::Parameters*, CoefficientsOf<double>*, int, double) noexcept;
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "BiquadDesign.h"
+
+/** How the cascade realises each band: a transposed direct form II biquad,
+    or a trapezoidal-integrated state-variable filter.
+*/
+enum class FilterTopology
+{
+    Biquad,
+    StateVariable
+};
+
+/** Allocation-free design of trapezoidal (TPT) state-variable filters, after
+    Zavalishin and Simper.
+
+    A design is five numbers, like a biquad's: the integrator gain g, the
+    damping k, and the mix of input, band-pass and low-pass outputs m0, m1
+    and m2. Every FilterType has one whose response matches the biquad
+    design exactly (same prewarping, Q and shelf slope), so switching
+    topology doesn't change the sound of a static band.
+
+    The difference is under modulation. The filter's state is its two
+    integrators, which mean the same thing whatever the coefficients are,
+    and it is stable for every g > 0 and k > 0. Any straight line between
+    two designs stays stable, so the cascade can move a band's coefficients
+    every sample, and a coefficient jump leaves no transient beyond the
+    change in response. A direct form biquad has neither property.
+
+    g is tan(pi f / fs), which fastTan() evaluates as a rational function
+    with no library call, so designing is cheap enough to do per tile for
+    every moving band.
+*/
+namespace StateVariableDesign
+{
+    // g, k, m0, m1, m2
+    template <typename SampleType>
+    using CoefficientsOf = BiquadDesign::CoefficientsOf<SampleType>;
+
+    /** tan(x) for 0 <= x < pi / 2, to within a few parts in 10^13. */
+    double fastTan(double x) noexcept;
+
+    /** Designs in double and rounds once to the sample type, as BiquadDesign does. */
+    template <typename SampleType>
+    void design(const BiquadDesign::Parameters& parameters, double sampleRate, CoefficientsOf<SampleType>& result) noexcept;
+
+    template <typename SampleType>
+    void designBatch(const BiquadDesign::Parameters* parameters, CoefficientsOf<SampleType>* results,
+                     int numBands, double sampleRate) noexcept;
+}
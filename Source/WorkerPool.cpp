@@ -0,0 +1,168 @@
+#include "WorkerPool.h"
+#include <thread>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker(WorkerPool& owner, int index)
+        : juce::Thread("SondyEQ Worker " + juce::String(index + 1)),
+          pool(owner)
+    {
+        startThread(juce::Thread::Priority::highest);
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(1000);
+    }
+
+    void wakeIfParked() noexcept
+    {
+        if (parked.load())
+            wakeUp.signal();
+    }
+
+    void run() override
+    {
+        // Denormal handling is per thread and the tasks run audio
+        juce::ScopedNoDenormals noDenormals;
+        auto lastGeneration = getGeneration();
+
+        while (!threadShouldExit())
+        {
+            const auto generation = getGeneration();
+
+            if (generation != lastGeneration)
+            {
+                lastGeneration = generation;
+                pool.runTasks(generation);
+                continue;
+            }
+
+            if (spinUntilNewBatch(lastGeneration))
+                continue;
+
+            // Park. The flag is set before the last look at the cursor and
+            // run() publishes before looking at the flag, so either this
+            // sees the new batch or run() sees the flag and signals.
+            parked.store(true);
+
+            if (getGeneration() == lastGeneration && !threadShouldExit())
+                wakeUp.wait(-1);
+
+            parked.store(false);
+        }
+    }
+
+private:
+    // Long enough to catch the next block of a small buffer size
+    static constexpr double spinSeconds = 100.0e-6;
+
+    WorkerPool& pool;
+    juce::WaitableEvent wakeUp;
+    std::atomic<bool> parked { false };
+
+    juce::uint32 getGeneration() const noexcept
+    {
+        return static_cast<juce::uint32>(pool.cursor.load() >> 32);
+    }
+
+    bool spinUntilNewBatch(juce::uint32 lastGeneration) const noexcept
+    {
+        const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        const auto end = juce::Time::getHighResolutionTicks() + static_cast<juce::int64>(spinSeconds * ticksPerSecond);
+
+        while (juce::Time::getHighResolutionTicks() < end)
+        {
+            for (int i = 0; i < 32; ++i)
+                WorkerPool::pause();
+
+            if (getGeneration() != lastGeneration)
+                return true;
+        }
+
+        return false;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(Worker)
+};
+
+WorkerPool::WorkerPool(int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back(std::make_unique<Worker>(*this, i));
+}
+
+WorkerPool::~WorkerPool()
+{
+    // Ask every worker to stop before joining any of them
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    workers.clear();
+}
+
+void WorkerPool::run(Task task, void* context, int numTasks) noexcept
+{
+    jassert(numTasks <= maxTasks);
+    numTasks = juce::jmin(numTasks, maxTasks);
+
+    if (numTasks <= 0)
+        return;
+
+    currentTask = task;
+    currentContext = context;
+    numFinished.store(0, std::memory_order_relaxed);
+
+    const auto generation = static_cast<juce::uint32>(cursor.load(std::memory_order_relaxed) >> 32) + 1;
+    cursor.store((static_cast<juce::uint64>(generation) << 32) | (static_cast<juce::uint64>(numTasks) << 16));
+
+    for (auto& worker : workers)
+        worker->wakeIfParked();
+
+    runTasks(generation);
+
+    // Everything is claimed by now; wait only for tasks still running on workers
+    while (numFinished.load(std::memory_order_acquire) < numTasks)
+        pause();
+}
+
+bool WorkerPool::runTasks(juce::uint32 generation) noexcept
+{
+    bool ranAny = false;
+    auto current = cursor.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto numTasks = static_cast<int>((current >> 16) & maxTasks);
+        const auto index = static_cast<int>(current & maxTasks);
+
+        if (static_cast<juce::uint32>(current >> 32) != generation || index >= numTasks)
+            return ranAny;
+
+        if (!cursor.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            continue;
+
+        currentTask(currentContext, index);
+        numFinished.fetch_add(1, std::memory_order_release);
+        ranAny = true;
+        current = cursor.load(std::memory_order_acquire);
+    }
+}
+
+void WorkerPool::pause() noexcept
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif JUCE_ARM && (JUCE_CLANG || JUCE_GCC)
+    __asm__ __volatile__ ("yield");
+   #else
+    std::this_thread::yield();
+   #endif
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/** A small pool of pre-spawned threads that helps the audio thread through
+    one block at a time.
+
+    run() publishes a batch of numbered tasks and then works on them itself
+    alongside the workers. Tasks are claimed one at a time with a
+    compare-and-swap, and run() returns once every task has finished. The
+    calling thread never waits for a worker to wake up. If none gets there
+    first, it runs every task itself, so the worst case is the
+    single-threaded cost. It only waits for tasks a worker has already
+    claimed.
+
+    Between batches the workers spin for a short while, because the next
+    block is usually close. After that they park on an event. Waking them is
+    one signal per parked worker, and parked workers cost nothing.
+*/
+class WorkerPool
+{
+public:
+    using Task = void (*)(void* context, int index) noexcept;
+
+    /** Starts numWorkers threads; the calling thread is an extra one during run(). */
+    explicit WorkerPool(int numWorkers);
+    ~WorkerPool();
+
+    int getNumWorkers() const noexcept { return static_cast<int>(workers.size()); }
+
+    /** One thread at a time (the audio thread): calls task(context, i) for every
+        i in [0, numTasks), spread over the pool and the caller, and returns
+        when all of them have finished. Doesn't lock or allocate. At most
+        65535 tasks per call.
+    */
+    void run(Task task, void* context, int numTasks) noexcept;
+
+    /** run() with a callable taking the task index. */
+    template <typename Function>
+    void forEach(int numTasks, Function& function) noexcept
+    {
+        run([](void* context, int index) noexcept { (*static_cast<Function*>(context))(index); },
+            &function, numTasks);
+    }
+
+private:
+    class Worker;
+
+    static constexpr int maxTasks = 0xffff;
+
+    // Batch generation in the high 32 bits, then the batch's task count and
+    // the next unclaimed task, 16 bits each. A claim is one compare-and-swap
+    // of the whole word, so a worker that arrives after its batch is over
+    // can never take a task from the next one.
+    std::atomic<juce::uint64> cursor { 0 };
+    std::atomic<int> numFinished { 0 };
+    Task currentTask = nullptr;
+    void* currentContext = nullptr;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /** Claims and runs tasks of the given generation until none are left;
+        returns true if it ran any.
+    */
+    bool runTasks(juce::uint32 generation) noexcept;
+
+    static void pause() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE(WorkerPool)
+};